@@ -5,16 +5,22 @@
 
 #pragma once
 #include <JuceHeader.h>
-#include "Data/GestureDetector.h"
+#include "Data/GestureManager.h"
 
+/**
+ * Calibration controls for one GestureManager. Requests go to its processing
+ * thread and the status shown is the calibration state it publishes back, so
+ * the detector is never touched from the message thread.
+ */
 class CalibrationComponent : public juce::Component,
                              private juce::Timer
 {
 public:
-    CalibrationComponent(GestureDetector& detectorRef)
-        : detector(detectorRef)
+    CalibrationComponent(GestureManager& managerRef)
+        : manager(managerRef)
     {
         setupUI();
+        startTimerHz(10);
     }
     
     ~CalibrationComponent()
@@ -29,7 +35,7 @@ public:
         g.drawRoundedRectangle(getLocalBounds().toFloat(), 5.0f, 1.0f);
 
         auto statusBounds = getLocalBounds().removeFromTop(40).reduced(10, 5);
-        if (detector.isCalibrated())
+        if (manager.isCalibrated())
         {
             g.setColour(juce::Colours::green.withAlpha(0.3f));
             g.fillRoundedRectangle(statusBounds.toFloat(), 3.0f);
@@ -53,6 +59,8 @@ public:
         calibrateButton.setBounds(bounds.removeFromTop(35));
         bounds.removeFromTop(5);
         resetButton.setBounds(bounds.removeFromTop(30));
+        bounds.removeFromTop(5);
+        driftToggle.setBounds(bounds.removeFromTop(25));
         bounds.removeFromTop(10);
         instructionsLabel.setBounds(bounds.removeFromTop(80));
     }
@@ -82,6 +90,17 @@ private:
         resetButton.setEnabled(false);
         resetButton.onClick = [this]() { resetCalibration(); };
         
+        addAndMakeVisible(driftToggle);
+        driftToggle.setButtonText("Track drift while still");
+        driftToggle.setToggleState(manager.getDetectorParameters().driftTracking, juce::dontSendNotification);
+        driftToggle.onClick = [this]()
+        {
+            auto parameters = manager.getDetectorParameters();
+            parameters.driftTracking = driftToggle.getToggleState();
+            manager.setDetectorParameters(parameters);
+            updateStatusLabel();
+        };
+        
         // Instructions
         addAndMakeVisible(instructionsLabel);
         instructionsLabel.setText("Hold the sensor in neutral position and click 'Start Calibration'. "
@@ -100,7 +119,7 @@ private:
         isCalibrating = true;
         calibrationProgress = 0.0f;
         
-        detector.startCalibration();
+        manager.startCalibration();
         calibrateButton.setEnabled(false);
         calibrateButton.setButtonText("Calibrating...");
         statusLabel.setText("Hold still...", juce::dontSendNotification);
@@ -116,24 +135,37 @@ private:
     
     void completeCalibration()
     {
-        detector.stopCalibration();
+        manager.stopCalibration();
         isCalibrating = false;
-        stopTimer();
+        awaitingResult = true;
+        resultWaitTicks = 0;
+    }
+    
+    // Called from the timer once the stop request has been applied (or given up on)
+    void showCalibrationResult()
+    {
+        awaitingResult = false;
+        shownCalibrated = manager.isCalibrated();
+        startTimerHz(10);
         
-        if (detector.isCalibrated())
+        if (manager.isCalibrated())
         {
             calibrateButton.setButtonText("Recalibrate");
             calibrateButton.setEnabled(true);
             resetButton.setEnabled(true);
             
-            statusLabel.setText("Calibration Complete!", juce::dontSendNotification);
+            statusLabel.setText("Calibration Complete! (confidence "
+                                + juce::String(juce::roundToInt(manager.getCalibrationState().calibration.confidence * 100.0f)) + "%)",
+                                juce::dontSendNotification);
             statusLabel.setColour(juce::Label::textColourId, juce::Colours::green);
         }
         else
         {
             calibrateButton.setButtonText("Start Calibration");
             calibrateButton.setEnabled(true);
-            statusLabel.setText("Calibration Failed - Try Again", juce::dontSendNotification);
+            statusLabel.setText(manager.isCalibrationSettled() ? "Calibration Failed - Try Again"
+                                                               : "Calibration Failed - No Sensor Data",
+                                juce::dontSendNotification);
             statusLabel.setColour(juce::Label::textColourId, juce::Colours::red);
         }
         
@@ -142,20 +174,25 @@ private:
     
     void resetCalibration()
     {
-        detector.resetCalibration();
+        manager.resetCalibration();
+        shownCalibrated = false;
         calibrateButton.setButtonText("Start Calibration");
         calibrateButton.setEnabled(true);
         resetButton.setEnabled(false);
         
-        updateStatusLabel();
+        // The published state only catches up once the request is applied
+        statusLabel.setText("Status: Not Calibrated", juce::dontSendNotification);
+        statusLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
         repaint();
     }
     
     void updateStatusLabel()
     {
-        if (detector.isCalibrated())
+        if (manager.isCalibrated())
         {
-            statusLabel.setText("Status: Calibrated", juce::dontSendNotification);
+            statusLabel.setText(manager.getDetectorParameters().driftTracking ? "Status: Calibrated (tracking drift)"
+                                                                              : "Status: Calibrated",
+                                juce::dontSendNotification);
             statusLabel.setColour(juce::Label::textColourId, juce::Colours::green);
         }
         else
@@ -175,22 +212,46 @@ private:
             
             calibrationProgress += 0.0167f;
             calibrationProgress = std::min(1.0f, calibrationProgress);
+            
+            statusLabel.setText("Hold still... confidence "
+                                + juce::String(juce::roundToInt(manager.getCalibrationState().confidence * 100.0f)) + "%",
+                                juce::dontSendNotification);
+            repaint();
+        }
+        else if (awaitingResult)
+        {
+            // The stop request is applied with the next block of frames; without any, give up
+            if (manager.isCalibrationSettled() || ++resultWaitTicks > maxResultWaitTicks)
+                showCalibrationResult();
+        }
+        else if (manager.isCalibrated() != shownCalibrated && manager.isCalibrationSettled())
+        {
+            // Calibration changed on the processing thread (e.g. a filter change dropped it)
+            shownCalibrated = manager.isCalibrated();
+            calibrateButton.setButtonText(shownCalibrated ? "Recalibrate" : "Start Calibration");
+            resetButton.setEnabled(shownCalibrated);
+            updateStatusLabel();
             repaint();
         }
     }
     
-    // Reference to detector
-    GestureDetector& detector;
+    // Requests and calibration state go through the manager
+    GestureManager& manager;
     
     // UI Components
     juce::Label titleLabel;
     juce::Label statusLabel;
     juce::TextButton calibrateButton;
     juce::TextButton resetButton;
+    juce::ToggleButton driftToggle;
     juce::Label instructionsLabel;
     
     // Animation state
     bool isCalibrating = false;
+    bool awaitingResult = false;
+    bool shownCalibrated = false;
+    int resultWaitTicks = 0;
+    static constexpr int maxResultWaitTicks = 30;   // 1 s at the calibrating frame rate
     float calibrationProgress = 0.0f;
     float animationPhase = 0.0f;
     
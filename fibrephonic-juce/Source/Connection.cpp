@@ -4,6 +4,8 @@
 #include <chrono>
 #include <iostream>
 #include <thread>
+#include <algorithm>
+#include <string>
 #include <inttypes.h>
 
 Connection::Connection(ConnectionManager* parent) : parentManager(parent)
@@ -15,20 +17,25 @@ void Connection::setupCallbacks()
 {
     decodeErrorCallback = [](auto error){ std::cout << ximu3::XIMU3_decode_error_to_string(error) << std::endl; };
     
-    statisticsCallback = [](auto statistics)
+    statisticsCallback = [this](auto statistics)
     {
-    printf(TIMESTAMP_FORMAT UINT64_FORMAT " bytes" UINT32_FORMAT " bytes/s" UINT64_FORMAT " messages" UINT32_FORMAT " messages/s" UINT64_FORMAT " errors" UINT32_FORMAT " errors/s\n",
-           statistics.timestamp,
-           statistics.data_total,
-           statistics.data_rate,
-           statistics.message_total,
-           statistics.message_rate,
-           statistics.error_total,
-           statistics.error_rate);
+        if (parentManager)
+        {
+            parentManager->setLinkStatistics(statistics);
+        }
     };
     
     inertialCallback = [this](auto message)
     {
+        lastDataMs.store(juce::Time::getMillisecondCounter(), std::memory_order_relaxed);
+        
+        // Wake runConnection so the first frame is reported as a connection straight away
+        if (!receivedData.load(std::memory_order_relaxed))
+        {
+            receivedData.store(true);
+            lifecycleEvent.signal();
+        }
+        
         if (parentManager)
         {
             parentManager->setGyroscopeValues(message.gyroscope_x,
@@ -38,6 +45,33 @@ void Connection::setupCallbacks()
             parentManager->setAccelerometerValues(message.accelerometer_x,
                                                   message.accelerometer_y,
                                                   message.accelerometer_z);
+            
+            // Inertial messages drive the frame rate; pair each with the latest magnetometer
+            // reading, and the latest AHRS output when that is being streamed
+            IMUData frame(message.accelerometer_x,
+                          message.accelerometer_y,
+                          message.accelerometer_z,
+                          message.gyroscope_x,
+                          message.gyroscope_y,
+                          message.gyroscope_z,
+                          static_cast<float>(parentManager->getMagnetometerX()),
+                          static_cast<float>(parentManager->getMagnetometerY()),
+                          static_cast<float>(parentManager->getMagnetometerZ()),
+                          message.timestamp);
+            
+            if (parentManager->getUseDeviceFusion())
+                parentManager->getFusionValues(frame);
+            
+            if (replaying)
+            {
+                // Replays never drop: the file reader waits for the pipeline instead
+                paceReplay(message.timestamp);
+                parentManager->pushSampleWaiting(frame);
+            }
+            else
+            {
+                parentManager->pushSample(frame);
+            }
         }
     };
     
@@ -51,41 +85,229 @@ void Connection::setupCallbacks()
         }
     };
     
-    endOfFileCallback = []{ std::cout << "End of file" << std::endl; };
+    // Linear acceleration messages carry the AHRS quaternion as well, so one stream gives both
+    linearAccelerationCallback = [this](auto message)
+    {
+        if (parentManager)
+        {
+            parentManager->setFusionValues(message.acceleration_x,
+                                           message.acceleration_y,
+                                           message.acceleration_z,
+                                           message.quaternion_w,
+                                           message.quaternion_x,
+                                           message.quaternion_y,
+                                           message.quaternion_z);
+        }
+    };
+    
+    endOfFileCallback = [this]
+    {
+        std::cout << "End of file" << std::endl;
+        endOfFile = true;
+        lifecycleEvent.signal();
+    };
+}
+
+void Connection::paceReplay(uint64_t timestamp)
+{
+    if (!replayRealTime)
+        return;
+    
+    if (!replayClockStarted || timestamp < replayFirstTimestamp)
+    {
+        replayClockStarted = true;
+        replayFirstTimestamp = timestamp;
+        replayStartTime = std::chrono::steady_clock::now();
+        return;
+    }
+    
+    std::this_thread::sleep_until(replayStartTime + std::chrono::microseconds(timestamp - replayFirstTimestamp));
 }
 
-void Connection::runConnection(const ximu3::ConnectionInfo& connectionInfo,
-                               std::function<bool()> shouldExit,
-                               std::function<void()> onConnectionSuccess)
+Connection::Outcome Connection::runConnection(const ximu3::ConnectionInfo& connectionInfo,
+                                              std::function<bool()> shouldExit,
+                                              std::function<void()> onConnectionSuccess)
 {
+    replaying = connectionInfo.getType() == ximu3::XIMU3_ConnectionTypeFile;
+    replayClockStarted = false;
+    endOfFile = false;
+    receivedData = false;
+    lifecycleEvent.reset();
+    
     ximu3::Connection connection(connectionInfo);
     
     connection.addDecodeErrorCallback(decodeErrorCallback);
+    connection.addStatisticsCallback(statisticsCallback);
     connection.addMagnetometerCallback(magnetometerCallback);
     connection.addInertialCallback(inertialCallback);
+    connection.addLinearAccelerationCallback(linearAccelerationCallback);
     connection.addEndOfFileCallback(endOfFileCallback);
     
-    if (connection.open() != ximu3::XIMU3_ResultOk)
+    // Open in the background so a stop request isn't stuck behind the SDK's own timeout.
+    // The result lives in shared state because the callback may outlive this call.
+    struct OpenState
+    {
+        juce::WaitableEvent finished;
+        std::atomic<ximu3::XIMU3_Result> result{ximu3::XIMU3_ResultError};
+    };
+    
+    auto openState = std::make_shared<OpenState>();
+    connection.openAsync([openState](auto result)
+    {
+        openState->result = result;
+        openState->finished.signal();
+    });
+    
+    const auto openStartMs = juce::Time::getMillisecondCounter();
+    while (!openState->finished.wait(watchdogIntervalMs))
+    {
+        if (shouldExit())
+            return Outcome::stopped;
+        
+        if (juce::Time::getMillisecondCounter() - openStartMs > static_cast<juce::uint32>(openTimeoutMs))
+            break;
+    }
+    
+    if (openState->result != ximu3::XIMU3_ResultOk)
     {
         std::cout << "Unable to open " << connectionInfo.toString() << std::endl;
-        return;
+        return Outcome::openFailed;
     }
     
-    // After a successful connection, we must call the callback
-    onConnectionSuccess();
+    lastDataMs = juce::Time::getMillisecondCounter();
 
-    // Tell the device to start streaming both inertial AND magnetometer data at 100 Hz
-    const std::vector<std::string> commands{
-        "{\"inertial\":{\"rate\":100}}",
-        "{\"magnetometer\":{\"rate\":100}}"  // Add magnetometer streaming!
-    };
-    connection.sendCommands(commands, 2, 500);
+    if (replaying)
+    {
+        onConnectionSuccess();
+        
+        // Recorded sessions already contain their streams; just play to the end
+        while (!shouldExit() && !endOfFile)
+        {
+            lifecycleEvent.wait(watchdogIntervalMs);
+        }
+        
+        connection.close();
+        return endOfFile ? Outcome::endOfFile : Outcome::stopped;
+    }
+    
+    // Tell the device to start streaming both inertial AND magnetometer data
+    int appliedRate = parentManager ? parentManager->getStreamRate() : defaultStreamRateHz;
+    bool appliedFusion = parentManager && parentManager->getUseDeviceFusion();
+    auto outcome = Outcome::stopped;
+    
+    if (!applyStreamRateOrExit(connection, appliedRate, appliedFusion, shouldExit))
+    {
+        connection.close();
+        return outcome;
+    }
+    
+    lastDataMs = juce::Time::getMillisecondCounter();
+    
+    // Sleep until woken (stop, rate change or first frame) or the watchdog interval passes,
+    // then check the link is still delivering data
+    bool reportedSuccess = false;
     
-    // Keep the connection alive until told to exit
     while (!shouldExit())
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        lifecycleEvent.wait(watchdogIntervalMs);
+        
+        if (shouldExit())
+            break;
+        
+        if (!reportedSuccess && receivedData.load())
+        {
+            reportedSuccess = true;
+            onConnectionSuccess();
+        }
+        
+        if (parentManager && (parentManager->getStreamRate() != appliedRate
+                              || parentManager->getUseDeviceFusion() != appliedFusion))
+        {
+            appliedRate = parentManager->getStreamRate();
+            appliedFusion = parentManager->getUseDeviceFusion();
+            
+            if (!applyStreamRateOrExit(connection, appliedRate, appliedFusion, shouldExit))
+                break;
+            
+            lastDataMs = juce::Time::getMillisecondCounter();
+        }
+        
+        if (juce::Time::getMillisecondCounter() - lastDataMs.load(std::memory_order_relaxed) > dataTimeoutMs)
+        {
+            std::cout << "No data from " << connectionInfo.toString() << " for "
+                      << dataTimeoutMs << " ms" << std::endl;
+            outcome = Outcome::linkLost;
+            break;
+        }
     }
     
     connection.close();
+    return outcome;
+}
+
+std::vector<std::string> Connection::getStreamingCommands(int rateHz, bool includeFusion)
+{
+    rateHz = juce::jlimit(minStreamRateHz, maxStreamRateHz, rateHz);
+    
+    // The magnetometer cannot usefully go above 100 Hz; frames reuse its latest reading
+    const int magnetometerRate = std::min(rateHz, 100);
+    
+    // Fusion runs alongside the inertial stream so every frame has a fresh estimate;
+    // rate 0 switches it off again
+    const int fusionRate = includeFusion ? rateHz : 0;
+    
+    return {
+        "{\"inertial\":{\"rate\":" + std::to_string(rateHz) + "}}",
+        "{\"magnetometer\":{\"rate\":" + std::to_string(magnetometerRate) + "}}",
+        "{\"linear_acceleration\":{\"rate\":" + std::to_string(fusionRate) + "}}"
+    };
+}
+
+void Connection::applyStreamRateAsync(ximu3::Connection& connection, int rateHz, bool includeFusion,
+                                      std::function<void(bool accepted)> onResult)
+{
+    const auto commands = getStreamingCommands(rateHz, includeFusion);
+    connection.sendCommandsAsync(commands, 2, 500, [numCommands = commands.size(), rateHz, onResult](const auto& responses)
+    {
+        const auto accepted = checkStreamingResponses(numCommands, responses, rateHz);
+        
+        if (onResult)
+            onResult(accepted);
+    });
+}
+
+bool Connection::applyStreamRateOrExit(ximu3::Connection& connection, int rateHz, bool includeFusion,
+                                       const std::function<bool()>& shouldExit)
+{
+    // Like the open, the reply may arrive after we have given up waiting for it - even
+    // after this Connection has gone - so the callback only touches state it shares ownership of
+    auto replyState = std::make_shared<juce::WaitableEvent>();
+    applyStreamRateAsync(connection, rateHz, includeFusion, [replyState](bool)
+    {
+        replyState->signal();
+    });
+    
+    while (!replyState->wait(watchdogIntervalMs))
+    {
+        if (shouldExit())
+            return false;
+    }
+    
+    return true;
+}
+
+bool Connection::checkStreamingResponses(size_t numCommands, const std::vector<std::string>& responses, int rateHz)
+{
+    // A command the device rejected or never answered comes back empty or as an error object
+    bool accepted = responses.size() == numCommands;
+    for (const auto& response : responses)
+    {
+        if (response.empty() || response.find("error") != std::string::npos)
+            accepted = false;
+    }
+    
+    if (!accepted)
+        std::cout << "Device did not accept stream rate " << rateHz << " Hz" << std::endl;
+    
+    return accepted;
 }
@@ -3,6 +3,8 @@
 #include <x-IMU3/Cpp/Ximu3.hpp>
 #include <functional>
 #include <JuceHeader.h>
+#include <atomic>
+#include <chrono>
 #include <vector>
 
 #define TIMESTAMP_FORMAT "%8" PRIu64 " us"
@@ -18,9 +20,52 @@ class Connection
 public:
     explicit Connection(ConnectionManager* parent = nullptr);
 
-    void runConnection(const ximu3::ConnectionInfo& connectionInfo,
-                       std::function<bool()> shouldExit,
-                       std::function<void()> onConnectionSuccess);
+    /** Why runConnection returned */
+    enum class Outcome
+    {
+        stopped,     ///< shouldExit() became true
+        openFailed,  ///< The connection could not be opened within openTimeoutMs
+        linkLost,    ///< No data arrived for dataTimeoutMs
+        endOfFile    ///< A file connection played to the end
+    };
+
+    /** Blocks until shouldExit() returns true, the link goes quiet, or a file connection ends.
+     *  onConnectionSuccess is called once the first inertial frame arrives - a UDP open succeeds
+     *  even with nothing at the address - or straight after the open for a file */
+    Outcome runConnection(const ximu3::ConnectionInfo& connectionInfo,
+                          std::function<bool()> shouldExit,
+                          std::function<void()> onConnectionSuccess);
+
+    /** Whether the last runConnection received any inertial frames */
+    bool hasReceivedData() const { return receivedData.load(); }
+
+    /** Wakes a blocked runConnection so it re-checks shouldExit() and the stream rate immediately */
+    void wake() { lifecycleEvent.signal(); }
+
+    /** Lifecycle timing */
+    static constexpr int openTimeoutMs = 3000;
+    static constexpr juce::uint32 dataTimeoutMs = 500;  ///< 25 frames at the slowest stream rate
+    static constexpr int watchdogIntervalMs = 50;
+
+    /** For file connections: pace frames by their timestamps (true) or replay as fast as
+     *  the pipeline can consume them without dropping any (false) */
+    void setReplayRealTime(bool shouldPaceToTimestamps) { replayRealTime = shouldPaceToTimestamps; }
+
+    /** Default and supported range for the inertial stream rate */
+    static constexpr int defaultStreamRateHz = 100;
+    static constexpr int minStreamRateHz = 50;
+    static constexpr int maxStreamRateHz = 1600;
+
+    /** Commands that start inertial and magnetometer streaming at the given rate, plus the
+     *  device's linear acceleration (AHRS quaternion + gravity-free acceleration) if requested */
+    static std::vector<std::string> getStreamingCommands(int rateHz = defaultStreamRateHz,
+                                                         bool includeFusion = false);
+
+    /** Sends the streaming commands without blocking - onResult (if any) is called from the SDK's
+     *  thread with whether every one was acknowledged, once the device has answered or the
+     *  retries are exhausted */
+    static void applyStreamRateAsync(ximu3::Connection& connection, int rateHz, bool includeFusion,
+                                     std::function<void(bool accepted)> onResult);
 
 private:
     ConnectionManager* parentManager = nullptr;
@@ -29,7 +74,27 @@ private:
     std::function<void(ximu3::XIMU3_Statistics statistics)> statisticsCallback;
     std::function<void(ximu3::XIMU3_InertialMessage message)> inertialCallback;
     std::function<void(ximu3::XIMU3_MagnetometerMessage message)> magnetometerCallback;
+    std::function<void(ximu3::XIMU3_LinearAccelerationMessage message)> linearAccelerationCallback;
     std::function<void()> endOfFileCallback;
 
+    juce::WaitableEvent lifecycleEvent;        ///< Signalled by wake() and at end of file
+    std::atomic<juce::uint32> lastDataMs{0};   ///< Host time of the last inertial message
+    std::atomic<bool> receivedData{false};     ///< Set by the first inertial message of a session
+
+    // File replay state
+    std::atomic<bool> endOfFile{false};
+    bool replaying = false;
+    bool replayRealTime = true;
+    bool replayClockStarted = false;
+    uint64_t replayFirstTimestamp = 0;
+    std::chrono::steady_clock::time_point replayStartTime;
+
     void setupCallbacks();
+    void paceReplay(uint64_t timestamp);
+
+    /** Applies the stream rate from runConnection, checking shouldExit() every watchdog interval
+     *  so a stop request isn't held up behind the device's reply - returns false if it became true */
+    bool applyStreamRateOrExit(ximu3::Connection& connection, int rateHz, bool includeFusion,
+                               const std::function<bool()>& shouldExit);
+    static bool checkStreamingResponses(size_t numCommands, const std::vector<std::string>& responses, int rateHz);
 };
@@ -7,6 +7,7 @@
 
 #include "ConnectionManager.h"
 #include "GestureManager.h"
+#include <iostream>
 
 ConnectionManager::ConnectionManager(std::shared_ptr<GestureManager> gestureManagerInstance)
 : juce::Thread("IMU Connection Thread")
@@ -21,30 +22,94 @@ ConnectionManager::ConnectionManager(std::shared_ptr<GestureManager> gestureMana
 ConnectionManager::~ConnectionManager()
 {
     signalThreadShouldExit();
+    connectionHandler->wake();
+    notify();
     stopThread(2000);
 }
 
 void ConnectionManager::startConnection()
 {
+    replayPath = {};
+    useSyntheticSource = false;
     startThread();
 }
 
+void ConnectionManager::startReplay(const juce::File& sessionFile, bool realTime)
+{
+    replayPath = sessionFile.getFullPathName();
+    replayRealTime = realTime;
+    useSyntheticSource = false;
+    startThread();
+}
+
+void ConnectionManager::setLinkStatistics(const ximu3::XIMU3_Statistics& statistics)
+{
+    if (auto gm = gestureManager.lock())
+    {
+        gm->getStats().recordLink(statistics);
+    }
+}
+
+void ConnectionManager::startSynthetic(const SyntheticDeviceSource::Parameters& parameters)
+{
+    replayPath = {};
+    useSyntheticSource = true;
+    syntheticParameters = parameters;
+    syntheticParameters.numDevices = 1;
+    startThread();
+}
+
+void ConnectionManager::handleConnectionSuccess()
+{
+    isConnected = true;
+    if (auto gm = gestureManager.lock())
+    {
+        if (!gm->getIsPolling())
+        {
+            gm->startPolling();
+        }
+    }
+}
+
+void ConnectionManager::handleConnectionLost()
+{
+    if (isConnected)
+    {
+        isConnected = false;
+        DBG("Device disconnected");
+    }
+}
+
 void ConnectionManager::stopConnection()
 {
+    // Wake whichever wait the thread is in so it exits without finishing a sleep
     signalThreadShouldExit();
+    connectionHandler->wake();
+    notify();
     stopThread(2000);
     isConnected = false;
+    
+    if (auto gm = gestureManager.lock())
+    {
+        gm->stopPolling();
+    }
 }
 
 void ConnectionManager::run()
 {
-    auto onConnectionSuccess = [this]() {
-        isConnected = true;
-        if (auto gm = gestureManager.lock())
-        {
-            gm->startPolling();
-        }
-    };
+    if (replayPath.isNotEmpty())
+    {
+        runReplay();
+        return;
+    }
+    
+    if (useSyntheticSource)
+    {
+        runSynthetic();
+        return;
+    }
+    
+    auto onConnectionSuccess = [this]() { handleConnectionSuccess(); };
 
     // Create network announcement for device discovery
     std::unique_ptr<ximu3::NetworkAnnouncement> networkAnnouncement;
@@ -69,23 +134,40 @@ void ConnectionManager::run()
 
     // Main connection loop
     int noDeviceCount = 0;
+    int cachedAttempts = 0;
     
     while (!threadShouldExit())
     {
         try
         {
+            // After a drop-out, go straight back to the device we were streaming from;
+            // announcements only arrive about once a second
+            if (lastDeviceInfo && cachedAttempts < MAX_CACHED_RECONNECT_ATTEMPTS)
+            {
+                const auto outcome = connectionHandler->runConnection(*lastDeviceInfo,
+                                                                      [this]() { return threadShouldExit(); },
+                                                                      onConnectionSuccess);
+                
+                if (outcome == Connection::Outcome::stopped)
+                    break;
+                
+                handleConnectionLost();
+                
+                // Retry immediately after a session that delivered data, otherwise back off briefly
+                // and give up on the cached address (powered off, or moved by DHCP) after a few tries
+                const bool receivedData = connectionHandler->hasReceivedData();
+                cachedAttempts = receivedData && outcome == Connection::Outcome::linkLost ? 0 : cachedAttempts + 1;
+                if (cachedAttempts > 0)
+                    waitForRetry(RECONNECT_BACKOFF_MS * cachedAttempts);
+                
+                continue;
+            }
+            
             const auto messages = networkAnnouncement->getMessagesAfterShortDelay();
 
             if (messages.empty())
             {
-                if (isConnected)
-                {
-                    isConnected = false;
-                    if (auto gm = gestureManager.lock())
-                    {
-                        gm->stopPolling();
-                    }
-                }
+                handleConnectionLost();
                 
                 // Log occasionally
                 if (++noDeviceCount == 1 || noDeviceCount % 50 == 0)
@@ -93,7 +175,7 @@ void ConnectionManager::run()
                     DBG("Searching for x-IMU3 devices...");
                 }
                 
-                juce::Thread::sleep(100);
+                waitForRetry(RECONNECT_BACKOFF_MS);
                 continue;
             }
 
@@ -104,35 +186,103 @@ void ConnectionManager::run()
             DBG("Connected: " << firstDevice.device_name
                 << " (Battery: " << static_cast<int>(firstDevice.battery) << "%)");
             
-            const auto& udpInfo = ximu3::XIMU3_network_announcement_message_to_udp_connection_info(firstDevice);
-            const auto& connectionInfo = ximu3::UdpConnectionInfo(udpInfo);
-
-            // This blocks until device disconnects or thread exits
-            connectionHandler->runConnection(connectionInfo,
-                                            [this]() { return threadShouldExit(); },
-                                            onConnectionSuccess);
-
-            if (!threadShouldExit())
-            {
-                isConnected = false;
-                DBG("Device disconnected");
-                if (auto gm = gestureManager.lock())
-                {
-                    gm->stopPolling();
-                }
-                juce::Thread::sleep(2000);
-            }
+            const auto udpInfo = ximu3::XIMU3_network_announcement_message_to_udp_connection_info(firstDevice);
+            
+            // The announcement may carry a new address (e.g. after DHCP), so refresh the cache
+            // and let the loop above connect to it
+            lastDeviceInfo = std::make_unique<ximu3::UdpConnectionInfo>(udpInfo);
+            cachedAttempts = 0;
         }
         catch (const std::exception& e)
         {
             DBG("Connection error: " << e.what());
-            isConnected = false;
-            if (!threadShouldExit())
-            {
-                juce::Thread::sleep(2000);
-            }
+            handleConnectionLost();
+            waitForRetry(RECONNECT_BACKOFF_MS);
         }
     }
 
     isConnected = false;
 }
+
+void ConnectionManager::runReplay()
+{
+    connectionHandler->setReplayRealTime(replayRealTime);
+    
+    const auto samplesBefore = sampleRing.getTotalPushed();
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    
+    try
+    {
+        connectionHandler->runConnection(ximu3::FileConnectionInfo(replayPath.toStdString()),
+                                         [this]() { return threadShouldExit(); },
+                                         [this]() { handleConnectionSuccess(); });
+    }
+    catch (const std::exception& e)
+    {
+        DBG("Replay error: " << e.what());
+    }
+    
+    // Let the gesture thread finish what is queued so the timing covers the whole pipeline
+    while (!threadShouldExit() && sampleRing.getNumReady() > 0)
+    {
+        juce::Thread::sleep(1);
+    }
+    
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    const auto samples = sampleRing.getTotalPushed() - samplesBefore;
+    
+    auto gm = gestureManager.lock();
+    const auto taps = gm ? gm->getTapCount() : 0;
+    
+    std::cout << "Replay " << (replayRealTime ? "(real time)" : "(as fast as possible)") << ": "
+              << samples << " samples in " << seconds << " s = "
+              << (seconds > 0.0 ? static_cast<double>(samples) / seconds : 0.0) << " samples/s, "
+              << taps << " taps, " << sampleRing.getOverrunCount() << " overruns" << std::endl;
+    
+    isConnected = false;
+    if (gm)
+    {
+        gm->stopPolling();
+    }
+    
+    if (onReplayFinished)
+    {
+        onReplayFinished();
+    }
+}
+
+void ConnectionManager::runSynthetic()
+{
+    // Frames enter exactly where Connection's callbacks would deliver them
+    SyntheticDeviceSource source(syntheticParameters, [this](int, const IMUData& frame)
+    {
+        setAccelerometerValues(frame.accelX, frame.accelY, frame.accelZ);
+        setGyroscopeValues(frame.gyroX, frame.gyroY, frame.gyroZ);
+        setMagnetometerValues(frame.magX, frame.magY, frame.magZ);
+        pushSample(frame);
+    });
+    
+    DBG("Synthetic device at " << syntheticParameters.rateHz << " Hz");
+    
+    handleConnectionSuccess();
+    source.start();
+    
+    while (!threadShouldExit())
+    {
+        wait(100);
+    }
+    
+    source.stop();
+    
+    auto gm = gestureManager.lock();
+    std::cout << "Synthetic: " << source.getFramesGenerated() << " frames, "
+              << source.getTapsInjected() << " taps injected, "
+              << (gm ? gm->getTapCount() : 0) << " detected, "
+              << sampleRing.getOverrunCount() << " overruns" << std::endl;
+    
+    isConnected = false;
+    if (gm)
+    {
+        gm->stopPolling();
+    }
+}
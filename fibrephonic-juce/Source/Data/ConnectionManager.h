@@ -9,8 +9,12 @@
 
 #include <JuceHeader.h>
 #include "../Connection.h"
+#include "../Helpers.h"
+#include "SampleRing.h"
+#include "SyntheticDeviceSource.h"
 #include <memory>
 #include <atomic>
+#include <thread>
 
 class GestureManager;
 
@@ -20,6 +24,8 @@ class GestureManager;
  *
  * Handles device discovery via network announcement, maintains connection,
  * and provides thread-safe access to sensor data (accelerometer, gyroscope, magnetometer).
+ * Every frame received is also queued on a lock-free ring so the gesture pipeline
+ * consumes each sample exactly once, independent of its own scheduling.
  */
 class ConnectionManager : public juce::Thread
 {
@@ -38,12 +44,50 @@ public:
     /** @brief Start the connection thread and begin device discovery */
     void startConnection();
     
+    /**
+     * @brief Feed a recorded .ximu3 session through the same pipeline as a live device
+     * @param sessionFile Recording made with the x-IMU3 GUI or DataLogger
+     * @param realTime    Pace frames by their timestamps, or run as fast as possible
+     *                    (lossless) to benchmark throughput
+     */
+    void startReplay(const juce::File& sessionFile, bool realTime);
+    
+    /**
+     * @brief Drive the pipeline from a built-in synthetic device instead of hardware
+     * Only one device is simulated here; use Ximu3DeviceManager for many.
+     */
+    void startSynthetic(const SyntheticDeviceSource::Parameters& parameters);
+    
+    /** @brief Called on the connection thread when a replay has been fully processed */
+    std::function<void()> onReplayFinished;
+    
     /** @brief Stop the connection thread and disconnect from device */
     void stopConnection();
     
     /** @brief Check if currently connected to a device */
     bool getIsConnected() const { return isConnected.load(); }
     
+    /** @brief Request an inertial stream rate; applied immediately if connected */
+    void setStreamRate(int rateHz)
+    {
+        streamRateHz.store(juce::jlimit(Connection::minStreamRateHz, Connection::maxStreamRateHz, rateHz));
+        connectionHandler->wake();
+    }
+    
+    int getStreamRate() const { return streamRateHz.load(); }
+    
+    /**
+     * @brief Stream the device's own AHRS output (orientation + gravity-free acceleration)
+     * and detect on that instead of the raw accelerometer; applied immediately if connected
+     */
+    void setUseDeviceFusion(bool shouldUse)
+    {
+        useDeviceFusion.store(shouldUse);
+        connectionHandler->wake();
+    }
+    
+    bool getUseDeviceFusion() const { return useDeviceFusion.load(); }
+    
     /** @name Sensor Data Accessors
      *  Thread-safe getters for sensor values
      *  @{
@@ -85,14 +129,100 @@ public:
         magnetometerY.store(y);
         magnetometerZ.store(z);
     }
+    
+    void setFusionValues(float linearX, float linearY, float linearZ,
+                         float qw, float qx, float qy, float qz)
+    {
+        linearAccelerationX.store(linearX);
+        linearAccelerationY.store(linearY);
+        linearAccelerationZ.store(linearZ);
+        quaternionW.store(qw);
+        quaternionX.store(qx);
+        quaternionY.store(qy);
+        quaternionZ.store(qz);
+        hasFusionValues.store(true);
+    }
+    
+    /** @brief Copy the latest AHRS output into a frame, if any has arrived */
+    void getFusionValues(IMUData& frame) const
+    {
+        if (!hasFusionValues.load())
+            return;
+        
+        frame.linearAccelX = linearAccelerationX.load();
+        frame.linearAccelY = linearAccelerationY.load();
+        frame.linearAccelZ = linearAccelerationZ.load();
+        frame.quatW = quaternionW.load();
+        frame.quatX = quaternionX.load();
+        frame.quatY = quaternionY.load();
+        frame.quatZ = quaternionZ.load();
+        frame.hasFusion = true;
+    }
+    /** @} */
+    
+    /** @name Sample Stream
+     *  Single-producer (Connection callback) / single-consumer (GestureManager) frame queue
+     *  @{
+     */
+    static constexpr size_t sampleRingSize = 4096; ///< ~4 s of headroom at 1 kHz
+    
+    /** @brief Queue a complete frame and wake the consumer - called from the x-IMU3 callback thread only */
+    void pushSample(const IMUData& frame)
+    {
+        if (sampleRing.push(frame))
+            sampleAvailable.signal();
+    }
+    
+    /** @brief Queue a frame, waiting for space rather than dropping it - used for replays */
+    void pushSampleWaiting(const IMUData& frame)
+    {
+        while (sampleRing.getNumReady() >= sampleRingSize && !threadShouldExit())
+            std::this_thread::yield();
+        
+        pushSample(frame);
+    }
+    
+    /** @brief Take up to maxFrames of the oldest queued frames - called from the gesture thread only */
+    size_t popSamples(IMUData* frames, size_t maxFrames) { return sampleRing.pop(frames, maxFrames); }
+    
+    /** @brief Block the gesture thread until a frame is queued or the timeout expires */
+    bool waitForSamples(int timeoutMs) const { return sampleAvailable.wait(timeoutMs); }
+    
+    /** @brief Release a consumer blocked in waitForSamples (used on shutdown) */
+    void wakeConsumer() const { sampleAvailable.signal(); }
+    
+    /** @brief Forward x-IMU3 link statistics to the gesture pipeline's metrics */
+    void setLinkStatistics(const ximu3::XIMU3_Statistics& statistics);
+    
+    uint64_t getSamplesReceived() const { return sampleRing.getTotalPushed(); }
+    uint64_t getSampleOverruns() const { return sampleRing.getOverrunCount(); }
     /** @} */
 
 protected:
     /** @brief Main thread loop - handles device discovery and connection */
     void run() override;
+    
+    /** @brief Thread body for file replays - plays the session once and reports throughput */
+    void runReplay();
+    
+    /** @brief Thread body for synthetic input - runs until the thread is stopped */
+    void runSynthetic();
+    
+    void handleConnectionSuccess();
+    
+    /** @brief Mark the link down; the gesture thread keeps waiting so a quick reconnect resumes seamlessly */
+    void handleConnectionLost();
+    
+    /** @brief Sleep until stopConnection() or the timeout, whichever comes first */
+    void waitForRetry(int timeoutMs) { wait(timeoutMs); }
 
 private:
+    /** Consecutive failed attempts on the cached device before falling back to discovery */
+    static constexpr int MAX_CACHED_RECONNECT_ATTEMPTS = 3;
+    static constexpr int RECONNECT_BACKOFF_MS = 50;
+    
     std::unique_ptr<Connection> connectionHandler;
+    std::unique_ptr<ximu3::UdpConnectionInfo> lastDeviceInfo; ///< Last device we streamed from, retried first
     std::weak_ptr<GestureManager> gestureManager; ///< Weak reference to avoid circular dependency
     
     /** @name Atomic Sensor Data Storage
@@ -102,9 +232,23 @@ private:
     std::atomic<double> accelerationX{0.0}, accelerationY{0.0}, accelerationZ{0.0};
     std::atomic<double> gyroscopeX{0.0}, gyroscopeY{0.0}, gyroscopeZ{0.0};
     std::atomic<double> magnetometerX{0.0}, magnetometerY{0.0}, magnetometerZ{0.0};
+    std::atomic<float> linearAccelerationX{0.0f}, linearAccelerationY{0.0f}, linearAccelerationZ{0.0f};
+    std::atomic<float> quaternionW{1.0f}, quaternionX{0.0f}, quaternionY{0.0f}, quaternionZ{0.0f};
+    std::atomic<bool> hasFusionValues{false};
     /** @} */
     
+    SampleRing<IMUData, sampleRingSize> sampleRing; ///< Frames awaiting gesture processing
+    juce::WaitableEvent sampleAvailable;           ///< Signalled whenever a frame is queued
+    
     std::atomic<bool> isConnected{false}; ///< Connection status flag
+    std::atomic<int> streamRateHz{Connection::defaultStreamRateHz}; ///< Requested inertial rate
+    std::atomic<bool> useDeviceFusion{false};                       ///< Requested AHRS streaming
+    
+    juce::String replayPath;   ///< Session file to replay instead of discovering devices
+    bool replayRealTime = true;
+    
+    bool useSyntheticSource = false;  ///< Generate frames instead of discovering devices
+    SyntheticDeviceSource::Parameters syntheticParameters;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConnectionManager)
 };
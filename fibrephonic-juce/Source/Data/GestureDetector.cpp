@@ -11,115 +11,337 @@
 #include "GestureDetector.h"
 #include <algorithm>
 
-GestureDetector::GestureDetector(size_t bufferSize)
-    : maxBuffer(bufferSize), offThreshold(tapThreshold) {}
+GestureDetector::GestureDetector(float historySecondsToKeep)
+    : historySeconds(historySecondsToKeep), offThreshold(tapThreshold)
+{
+    // Spectral onsets are switched on from the processing thread, so plan their FFT and
+    // allocate the detector now; the switch itself only flips a flag
+    SpectralFluxDetector::preparePlan(onsetFFTSize);
+    onsetDetector = std::make_unique<SpectralFluxDetector>(onsetFFTSize);
+    
+    updateTapLanes();
+    updateWindowLengths();
+}
 
 float GestureDetector::magnitude(const IMUData& d) const
 {
     return std::sqrt(d.accelX*d.accelX + d.accelY*d.accelY + d.accelZ*d.accelZ);
 }
 
-float GestureDetector::mean(const std::vector<float>& v) const
+float GestureDetector::latestMagnitude() const
+{
+    const float x = history.latest(History::AccelX);
+    const float y = history.latest(History::AccelY);
+    const float z = history.latest(History::AccelZ);
+    return std::sqrt(x*x + y*y + z*z);
+}
+
+// Keeps a running sample-rate estimate from device timestamps, and stamps
+// frames from sources without a clock at the nominal rate
+void GestureDetector::updateTiming(IMUData& sample)
 {
-    if (v.empty()) return 0.0f;
-    return std::accumulate(v.begin(), v.end(), 0.0f) / v.size();
+    if (sample.timestamp == 0)
+        sample.timestamp = hasTimestamp ? lastTimestamp + static_cast<uint64_t>(1.0e6f / sampleRate) : 0;
+    
+    if (hasTimestamp && sample.timestamp > lastTimestamp)
+    {
+        const float instantaneousRate = 1.0e6f / static_cast<float>(sample.timestamp - lastTimestamp);
+        sampleRate = rateMeasured ? sampleRate + 0.05f * (instantaneousRate - sampleRate)
+                                  : instantaneousRate;
+        rateMeasured = true;
+    }
+    else if (hasTimestamp && sample.timestamp < lastTimestamp)
+    {
+        refractoryEndTime = 0; // Device clock restarted, e.g. after a reconnect
+    }
+    
+    lastTimestamp = sample.timestamp;
+    hasTimestamp = true;
+}
+
+// With on-device AHRS the accelerometer channels are replaced by gravity-free
+// acceleration, so the calibration baseline no longer depends on how the
+// textile is lying. A baseline taken on the other source is meaningless,
+// so switching source drops the calibration.
+void GestureDetector::selectMotionSource(IMUData& sample)
+{
+    if (sample.hasFusion != usingDeviceFusion)
+    {
+        usingDeviceFusion = sample.hasFusion;
+        history.clear();
+        calib = Calibration{};
+        magnitudeStats = xStats = yStats = zStats = RunningStats{};
+        calibrationConfidence = 0.0f;
+        resetStroke();
+        wavelets.reset();
+        
+        onsetDetector->reset();
+    }
+    
+    if (sample.hasFusion)
+    {
+        orientationW = sample.quatW;
+        orientationX = sample.quatX;
+        orientationY = sample.quatY;
+        orientationZ = sample.quatZ;
+        
+        sample.accelX = sample.linearAccelX;
+        sample.accelY = sample.linearAccelY;
+        sample.accelZ = sample.linearAccelZ;
+    }
 }
 
-float GestureDetector::stddev(const std::vector<float>& v, float m) const
+// History and tap-peak windows are specified in seconds, so their sample
+// counts follow the rate estimate
+void GestureDetector::updateWindowLengths()
 {
-    if (v.size() < 2) return 0.0f;
-    float s = 0.0f;
-    for (auto x : v) s += (x-m)*(x-m);
-    return std::sqrt(s / (v.size()-1));
+    history.setLength(static_cast<size_t>(historySeconds * sampleRate));
+    tapPeak.setWindow(static_cast<size_t>(tapWindowSeconds * sampleRate));
+    
+    wavelets.setAveragingLength(waveletAveragingSeconds * sampleRate);
+    
+    onsetDetector->setAdaptationLength(onsetAdaptationSeconds * sampleRate);
 }
 
-void GestureDetector::pushSample(const IMUData& sample)
+void GestureDetector::ingestSample(const IMUData& input)
 {
-    buffer.push_back(sample);
-    if (buffer.size() > maxBuffer)
-        buffer.pop_front();
+    IMUData sample = input;
+    updateTiming(sample);
+    selectMotionSource(sample);
+    
+    history.push(sample);
+    
+    const float motion[WaveletEnergies::numAxes] = { sample.accelX, sample.accelY, sample.accelZ,
+                                                     sample.gyroX, sample.gyroY, sample.gyroZ };
+    wavelets.push(motion);
 
     if (calibrating)
     {
-        calibrationBuffer.push_back(sample);
+        accumulateCalibration(sample);
     }
+    else if (calib.calibrated && driftTracking)
+    {
+        trackDrift();
+    }
+}
+
+void GestureDetector::pushSample(const IMUData& input)
+{
+    ingestSample(input);
+    updateWindowLengths();
+}
+
+// Batch form of pushSample/detectTap/detectStroke. The rate estimate barely moves
+// within a block, so the windows that follow it are resized once per block, and
+// the tap mode is fixed for the block, leaving the loop with no per-sample setup.
+size_t GestureDetector::processBlock(const IMUData* samples, size_t numSamples, std::vector<DetectionEvent>& events)
+{
+    const size_t firstEvent = events.size();
+    const bool multiAxis = multiAxisTaps;
+    SpectralFluxDetector* const onsets = spectralOnsets ? onsetDetector.get() : nullptr;
+    
+    updateWindowLengths();
+    
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        ingestSample(samples[i]);
+        
+        const float velocity = multiAxis ? detectTapMultiAxis() : detectTapSingleAxis();
+        if (velocity > 0.0f)
+        {
+            DetectionEvent& tap = events.emplace_back();
+            tap.offset = i;
+            tap.timestamp = lastTimestamp;
+            tap.type = Gestures::TAP;
+            tap.velocity = velocity;
+            tap.tapId = tapId;
+            if (multiAxis)
+                tap.tapAxes = lastTapAxes;
+        }
+        else if (tapStarting && earlyTaps)
+        {
+            // A tap opens and closes on different samples, so this never shares a slot with the TAP
+            DetectionEvent& tapOnset = events.emplace_back();
+            tapOnset.offset = i;
+            tapOnset.timestamp = lastTimestamp;
+            tapOnset.type = Gestures::TAP_ONSET;
+            tapOnset.velocity = tapOnsetLevel;
+            tapOnset.tapId = tapId;
+        }
+        
+        if (onsets != nullptr)
+        {
+            const float flux = onsets->process(latestMagnitude());
+            if (flux > 0.0f)
+            {
+                DetectionEvent& onset = events.emplace_back();
+                onset.offset = i;
+                onset.timestamp = lastTimestamp;
+                onset.type = Gestures::ONSET;
+                onset.velocity = flux;
+            }
+        }
+        
+        const StrokeEvent stroke = detectStroke();
+        if (stroke.direction != Gestures::NONE)
+        {
+            DetectionEvent& event = events.emplace_back();
+            event.offset = i;
+            event.timestamp = lastTimestamp;
+            event.type = stroke.direction;
+            event.velocity = stroke.speed;
+            event.durationSeconds = stroke.durationSeconds;
+        }
+    }
+    
+    updateWindowLengths();
+    return events.size() - firstEvent;
 }
 
 void GestureDetector::startCalibration()
 {
+    magnitudeStats = xStats = yStats = zStats = RunningStats{};
+    calibrationConfidence = 0.0f;
     calibrating = true;
-    calibrationBuffer.clear();
     calib.calibrated = false;
 }
 
 void GestureDetector::stopCalibration()
 {
     calibrating = false;
-    if (!calibrationBuffer.empty())
+    if (magnitudeStats.count > 0)
     {
-        calculateCalibration();
+        calib = getLiveCalibration();
         calib.calibrated = true;
     }
+    
+    driftSeeded = false;
+    driftSamples = 0;
 }
 
 // Calibration approach adapted from Mi.mu GestureDetector
-// Uses statistical baseline (mean + standard deviation) for threshold normalization
-void GestureDetector::calculateCalibration()
+// Uses statistical baseline (mean + standard deviation) for threshold normalization,
+// accumulated one sample at a time
+void GestureDetector::accumulateCalibration(const IMUData& sample)
 {
-    std::vector<float> magnitudes, xVals, yVals, zVals;
+    magnitudeStats.add(magnitude(sample));
+    xStats.add(sample.accelX);
+    yStats.add(sample.accelY);
+    zStats.add(sample.accelZ);
     
-    for (const auto& sample : calibrationBuffer)
+    const float coverage = std::min(1.0f, static_cast<float>(magnitudeStats.count)
+                                          / (calibrationTargetSeconds * sampleRate));
+    const float stillness = std::clamp(1.0f - magnitudeStats.getStdDev() / calibrationMaxStd, 0.0f, 1.0f);
+    calibrationConfidence = coverage * stillness;
+}
+
+// Continuous recalibration: exponentially weighted statistics, seeded from the
+// manual calibration, that only see samples taken while the textile is still.
+// A step change bigger than the movement threshold reads as movement and is
+// never absorbed - that still needs a manual recalibration.
+void GestureDetector::trackDrift()
+{
+    if (getDirectionalInfo().isMoving)
+        return;
+    
+    if (!driftSeeded)
     {
-        magnitudes.push_back(magnitude(sample));
-        xVals.push_back(sample.accelX);
-        yVals.push_back(sample.accelY);
-        zVals.push_back(sample.accelZ);
+        driftMagnitude.seed(calib.baselineMagnitude, calib.baselineStd);
+        driftX.seed(calib.baselineX, calib.stdX);
+        driftY.seed(calib.baselineY, calib.stdY);
+        driftZ.seed(calib.baselineZ, calib.stdZ);
+        driftSeeded = true;
     }
     
+    const float alpha = std::min(1.0f, 1.0f / (driftTimeConstantSeconds * sampleRate));
+    const float x = history.latest(History::AccelX);
+    const float y = history.latest(History::AccelY);
+    const float z = history.latest(History::AccelZ);
+    
+    driftMagnitude.add(std::sqrt(x*x + y*y + z*z), alpha);
+    driftX.add(x, alpha);
+    driftY.add(y, alpha);
+    driftZ.add(z, alpha);
+    
+    calib.baselineMagnitude = driftMagnitude.mean;
+    calib.baselineStd = driftMagnitude.getStdDev();
+    calib.baselineX = driftX.mean;
+    calib.baselineY = driftY.mean;
+    calib.baselineZ = driftZ.mean;
+    calib.stdX = driftX.getStdDev();
+    calib.stdY = driftY.getStdDev();
+    calib.stdZ = driftZ.getStdDev();
+    
+    ++driftSamples;
+}
+
+GestureDetector::Calibration GestureDetector::getLiveCalibration() const
+{
+    Calibration live;
+    
     // Overall magnitude baseline - Mi.mu approach for gesture normalization
-    calib.baselineMagnitude = mean(magnitudes);
-    calib.baselineStd = stddev(magnitudes, calib.baselineMagnitude);
+    live.baselineMagnitude = magnitudeStats.getMean();
+    live.baselineStd = magnitudeStats.getStdDev();
     
     // Individual axis baselines for directional analysis
-    calib.baselineX = mean(xVals);
-    calib.baselineY = mean(yVals);
-    calib.baselineZ = mean(zVals);
-    calib.stdX = stddev(xVals, calib.baselineX);
-    calib.stdY = stddev(yVals, calib.baselineY);
-    calib.stdZ = stddev(zVals, calib.baselineZ);
+    live.baselineX = xStats.getMean();
+    live.baselineY = yStats.getMean();
+    live.baselineZ = zStats.getMean();
+    live.stdX = xStats.getStdDev();
+    live.stdY = yStats.getStdDev();
+    live.stdZ = zStats.getStdDev();
+    
+    live.sampleCount = magnitudeStats.count;
+    live.confidence = getCalibrationConfidence();
+    live.calibrated = calib.calibrated;
+    return live;
 }
 
 void GestureDetector::resetCalibration()
 {
     calib = Calibration{};
-    calibrationBuffer.clear();
+    magnitudeStats = xStats = yStats = zStats = RunningStats{};
+    calibrationConfidence = 0.0f;
     calibrating = false;
+    driftSeeded = false;
+    driftSamples = 0;
+    resetStroke();
 }
 
 // Adapted from Mi.mu DrumDetector for textile tap detection
 // Original algorithm designed for detecting drum hits via gyroscope analysis
 float GestureDetector::detectTap()
 {
-    if (buffer.empty()) return 0.0f;
+    if (history.empty()) return 0.0f;
     
-    if (countDownTimer > 0)
-        --countDownTimer;
-    
-    float input = buffer.back().gyroZ;
+    return multiAxisTaps ? detectTapMultiAxis() : detectTapSingleAxis();
+}
+
+float GestureDetector::detectTapSingleAxis()
+{
+    const uint64_t now = history.latestTimestamp();
+    float input = history.latest(History::GyroZ);
+    tapStarting = false;
     
-    tapBuffer.push_back(input);
-    if (tapBuffer.size() > 50) // Keep last 50 samples (~0.5s at 100Hz)
-        tapBuffer.pop_front();
+    // Track the peak over the last ~0.5 s whatever the stream rate
+    tapPeak.push(input);
     
     if (isThresholdExceeded(input))
     {
-        if (countDownTimer == 0)
+        if (now >= refractoryEndTime)
         {
+            if (!tapPending)
+            {
+                tapStarting = true;
+                tapOnsetLevel = std::abs(input);
+                ++tapId;
+            }
+            
             tapPending = true;
         }
         else
         {
-            countDownTimer = static_cast<int>(0.01 * sampleRate); // Reset to 20ms
+            refractoryEndTime = now + refractoryPeriod; // Extend the refractory window
         }
     }
     else if (tapPending)
@@ -127,14 +349,255 @@ float GestureDetector::detectTap()
         float velocity = getMaxMagnitude();
         tapPending = false;
         offThreshold = tapThreshold;
-        tapBuffer.clear();
-        countDownTimer = static_cast<int>(0.01 * sampleRate);
+        tapPeak.reset();
+        refractoryEndTime = now + refractoryPeriod;
+        lastTapTimestamp = now;
         return velocity;
     }
     
     return 0.0f;
 }
 
+void GestureDetector::resetStroke()
+{
+    strokeFilteredX = strokeFilteredY = 0.0f;
+    strokeVelocityX = strokeVelocityY = 0.0f;
+    strokePeakSpeed = 0.0f;
+    strokeActive = false;
+}
+
+// Streaming stroke recogniser: a horizontal swell of the calibrated acceleration
+// (the same deltas getDirectionalInfo uses) opens a stroke, it is integrated while
+// it lasts, and on release the dominant axis and sign give the direction.
+// Fixed work per sample - no history scans - so it can sit beside tap detection
+// on every device.
+GestureDetector::StrokeEvent GestureDetector::detectStroke()
+{
+    StrokeEvent event;
+    
+    if (history.empty() || !calib.calibrated)
+    {
+        strokeActive = false;
+        return event;
+    }
+    
+    const uint64_t now = history.latestTimestamp();
+    const float dt = 1.0f / sampleRate;
+    const float alpha = std::min(1.0f, dt / strokeSmoothingSeconds);
+    
+    strokeFilteredX += alpha * (history.latest(History::AccelX) - calib.baselineX - strokeFilteredX);
+    strokeFilteredY += alpha * (history.latest(History::AccelY) - calib.baselineY - strokeFilteredY);
+    
+    const float horizontal = std::sqrt(strokeFilteredX*strokeFilteredX + strokeFilteredY*strokeFilteredY);
+    const float onThreshold = std::max(strokeMinG, 3.0f * calib.baselineStd);
+    
+    if (!strokeActive)
+    {
+        if (horizontal <= onThreshold)
+            return event;
+        
+        strokeActive = true;
+        strokeStartTime = now;
+        strokeVelocityX = strokeVelocityY = 0.0f;
+        strokePeakSpeed = 0.0f;
+    }
+    
+    if (now < strokeStartTime)
+    {
+        strokeActive = false; // Device clock restarted mid-stroke
+        return event;
+    }
+    
+    constexpr float gravity = 9.81f;
+    strokeVelocityX += strokeFilteredX * gravity * dt;
+    strokeVelocityY += strokeFilteredY * gravity * dt;
+    strokePeakSpeed = std::max(strokePeakSpeed, std::sqrt(strokeVelocityX*strokeVelocityX
+                                                          + strokeVelocityY*strokeVelocityY));
+    
+    // Hysteresis: the stroke lasts until the swell falls to half the onset level
+    if (horizontal > 0.5f * onThreshold)
+        return event;
+    
+    strokeActive = false;
+    
+    const uint64_t duration = now - strokeStartTime;
+    if (duration < strokeMinDuration || duration > strokeMaxDuration)
+        return event;
+    
+    const float absX = std::abs(strokeVelocityX);
+    const float absY = std::abs(strokeVelocityY);
+    if (std::max(absX, absY) < strokeDominance * std::min(absX, absY))
+        return event; // Diagonal or ambiguous
+    
+    if (absX > absY)
+        event.direction = strokeVelocityX > 0.0f ? Gestures::STROKE_RIGHT : Gestures::STROKE_LEFT;
+    else
+        event.direction = strokeVelocityY > 0.0f ? Gestures::STROKE_UP : Gestures::STROKE_DOWN;
+    
+    event.speed = strokePeakSpeed;
+    event.durationSeconds = static_cast<float>(duration) * 1.0e-6f;
+    event.startTimestamp = strokeStartTime;
+    lastStrokeTimestamp = now;
+    return event;
+}
+
+void GestureDetector::setParameters(const Parameters& parameters)
+{
+    tapThreshold = parameters.tapThreshold;
+    gyroThreshold = parameters.gyroThreshold;
+    accelTapThreshold = parameters.accelTapThreshold;
+    driftTracking = parameters.driftTracking;
+    updateTapLanes();
+}
+
+GestureDetector::Parameters GestureDetector::getParameters() const
+{
+    Parameters parameters;
+    parameters.tapThreshold = tapThreshold;
+    parameters.gyroThreshold = gyroThreshold;
+    parameters.accelTapThreshold = accelTapThreshold;
+    parameters.driftTracking = driftTracking;
+    return parameters;
+}
+
+void GestureDetector::setMultiAxisTaps(bool enabled, uint32_t axisMask)
+{
+    multiAxisTaps = enabled;
+    tapAxisMask = axisMask & allTapAxes;
+    laneBaselineSet = false;
+    std::fill(std::begin(lanePending), std::end(lanePending), 0.0f);
+    std::fill(std::begin(lanePeak), std::end(lanePeak), 0.0f);
+    updateTapLanes();
+}
+
+void GestureDetector::setSpectralOnsets(bool enabled, int hopSize)
+{
+    // Switching on starts from a clean slate, as a newly created detector would
+    if (enabled && !spectralOnsets)
+        onsetDetector->reset();
+    
+    spectralOnsets = enabled;
+    onsetDetector->setHopSize(hopSize);
+}
+
+void GestureDetector::updateTapLanes()
+{
+    for (int i = 0; i < tapLanes; ++i)
+    {
+        const bool isAxis = i < numTapAxes && (tapAxisMask & (1u << i)) != 0;
+        laneEnabled[i] = isAxis ? 1.0f : 0.0f;
+        laneThreshold[i] = i < History::GyroX ? accelTapThreshold : std::abs(tapThreshold);
+        laneOffThreshold[i] = laneThreshold[i];
+    }
+}
+
+// The drum-detector state machine run on every axis at once. Each lane is the
+// absolute deviation from a slow baseline, so accelerometer lanes ignore gravity
+// and gyro lanes ignore bias, and the hysteresis mirrors isThresholdExceeded().
+// Per-lane work is branch-free arithmetic over fixed-size arrays; only the
+// (rare) tap bookkeeping is scalar.
+float GestureDetector::detectTapMultiAxis()
+{
+    const uint64_t now = history.latestTimestamp();
+    tapStarting = false;
+    
+    alignas(32) float input[tapLanes] = {};
+    for (int axis = 0; axis < numTapAxes; ++axis)
+        input[axis] = history.latest(static_cast<History::Axis>(axis));
+    
+    if (!laneBaselineSet)
+    {
+        std::copy(std::begin(input), std::end(input), std::begin(laneBaseline));
+        laneBaselineSet = true;
+    }
+    
+    const float baselineAlpha = std::min(1.0f, 1.0f / (tapBaselineSeconds * sampleRate));
+    alignas(32) float above[tapLanes];
+    
+    for (int i = 0; i < tapLanes; ++i)
+    {
+        const float idle = 1.0f - lanePending[i];
+        
+        // The baseline freezes while a lane is mid-tap so the tap isn't absorbed into it
+        laneBaseline[i] += baselineAlpha * idle * (input[i] - laneBaseline[i]);
+        const float deviation = std::abs(input[i] - laneBaseline[i]) * laneEnabled[i];
+        
+        // Release level trails the peak by one threshold while pending, resets when idle
+        laneOffThreshold[i] = lanePending[i] * std::max(laneOffThreshold[i], deviation - laneThreshold[i])
+                            + idle * laneThreshold[i];
+        
+        const float level = lanePending[i] * laneOffThreshold[i] + idle * laneThreshold[i];
+        above[i] = deviation > level ? 1.0f : 0.0f;
+        lanePeak[i] = std::max(lanePeak[i], deviation * std::max(above[i], lanePending[i]));
+    }
+    
+    float anyAbove = 0.0f, anyPending = 0.0f;
+    for (int i = 0; i < tapLanes; ++i)
+    {
+        anyAbove = std::max(anyAbove, above[i]);
+        anyPending = std::max(anyPending, lanePending[i]);
+    }
+    
+    if (anyAbove > 0.0f)
+    {
+        if (now >= refractoryEndTime)
+        {
+            if (anyPending == 0.0f)
+            {
+                // Crossing strength in the same gyro-Z-equivalent units as the final velocity
+                float strongest = 0.0f;
+                for (int axis = 0; axis < numTapAxes; ++axis)
+                    strongest = std::max(strongest, above[axis] * std::abs(input[axis] - laneBaseline[axis]) / laneThreshold[axis]);
+                
+                tapStarting = true;
+                tapOnsetLevel = strongest * std::abs(tapThreshold);
+                ++tapId;
+            }
+            
+            for (int i = 0; i < tapLanes; ++i)
+                lanePending[i] = std::max(lanePending[i], above[i]);
+        }
+        else
+        {
+            refractoryEndTime = now + refractoryPeriod; // Extend the refractory window
+            if (anyPending == 0.0f)
+                std::fill(std::begin(lanePeak), std::end(lanePeak), 0.0f);
+        }
+        
+        return 0.0f;
+    }
+    
+    if (anyPending == 0.0f)
+    {
+        std::fill(std::begin(lanePeak), std::end(lanePeak), 0.0f);
+        return 0.0f;
+    }
+    
+    // Every lane is back below its release level - the tap is over. The axis that
+    // went furthest past its own threshold is the one that fired.
+    int firedAxis = 0;
+    float strongest = 0.0f;
+    for (int axis = 0; axis < numTapAxes; ++axis)
+    {
+        const float strength = lanePending[axis] * lanePeak[axis] / laneThreshold[axis];
+        if (strength > strongest)
+        {
+            strongest = strength;
+            firedAxis = axis;
+        }
+        lastTapAxes.peaks[axis] = lanePeak[axis];
+    }
+    lastTapAxes.firedAxis = firedAxis;
+    
+    std::fill(std::begin(lanePending), std::end(lanePending), 0.0f);
+    std::fill(std::begin(lanePeak), std::end(lanePeak), 0.0f);
+    refractoryEndTime = now + refractoryPeriod;
+    lastTapTimestamp = now;
+    
+    // Velocity in gyro-Z-equivalent units so downstream scaling matches the single-axis mode
+    return strongest * std::abs(tapThreshold);
+}
+
 // Directly adapted from Mi.mu DrumDetector::isThreshExceeded()
 // Implements adaptive threshold with hysteresis for reliable detection
 bool GestureDetector::isThresholdExceeded(float input)
@@ -166,47 +629,49 @@ bool GestureDetector::isThresholdExceeded(float input)
 
 // Adapted from Mi.mu DrumDetector::getMaxMagnitude()
 // Returns peak velocity from recent samples for dynamics
+// The window is the gyro history since the last tap, capped at ~0.5 s;
+// the sliding extrema make this a constant-time read
 float GestureDetector::getMaxMagnitude()
 {
-    if (tapBuffer.empty()) return 0.0f;
+    if (tapPeak.empty()) return 0.0f;
     
     if (tapThreshold > 0.0f)
     {
-        return *std::max_element(tapBuffer.begin(), tapBuffer.end());
+        return tapPeak.getMax();
     }
     else
     {
-        return std::abs(*std::min_element(tapBuffer.begin(), tapBuffer.end()));
+        return std::abs(tapPeak.getMin());
     }
 }
 
 float GestureDetector::getMagnitude() const
 {
-    return buffer.empty() ? 0.0f : magnitude(buffer.back());
+    return history.empty() ? 0.0f : latestMagnitude();
 }
 
 float GestureDetector::getCalibratedMagnitude() const
 {
-    if (buffer.empty() || !calib.calibrated) return 0.0f;
-    return magnitude(buffer.back()) - calib.baselineMagnitude;
+    if (history.empty() || !calib.calibrated) return 0.0f;
+    return latestMagnitude() - calib.baselineMagnitude;
 }
 
 float GestureDetector::getCalibratedX() const
 {
-    if (buffer.empty() || !calib.calibrated) return 0.0f;
-    return buffer.back().accelX - calib.baselineX;
+    if (history.empty() || !calib.calibrated) return 0.0f;
+    return history.latest(History::AccelX) - calib.baselineX;
 }
 
 float GestureDetector::getCalibratedY() const
 {
-    if (buffer.empty() || !calib.calibrated) return 0.0f;
-    return buffer.back().accelY - calib.baselineY;
+    if (history.empty() || !calib.calibrated) return 0.0f;
+    return history.latest(History::AccelY) - calib.baselineY;
 }
 
 float GestureDetector::getCalibratedZ() const
 {
-    if (buffer.empty() || !calib.calibrated) return 0.0f;
-    return buffer.back().accelZ - calib.baselineZ;
+    if (history.empty() || !calib.calibrated) return 0.0f;
+    return history.latest(History::AccelZ) - calib.baselineZ;
 }
 
 // Directional analysis adapted from Mi.mu DirectionProcessor concept
@@ -215,22 +680,37 @@ GestureDetector::DirectionalInfo GestureDetector::getDirectionalInfo() const
 {
     DirectionalInfo info;
     
-    if (buffer.empty() || !calib.calibrated)
+    if (history.empty())
         return info;
     
-    const auto& current = buffer.back();
+    // With an orientation estimate the acceleration channels are gravity-free and
+    // say nothing about pose, so tilt is the gravity direction in the sensor frame
+    // (the sine of the tilt about each axis), calibrated or not
+    if (usingDeviceFusion)
+    {
+        info.tiltX = std::clamp(2.0f * (orientationX * orientationZ - orientationW * orientationY), -1.0f, 1.0f);
+        info.tiltY = std::clamp(2.0f * (orientationW * orientationX + orientationY * orientationZ), -1.0f, 1.0f);
+        info.tiltZ = std::clamp(orientationW * orientationW - orientationX * orientationX
+                                - orientationY * orientationY + orientationZ * orientationZ, -1.0f, 1.0f);
+    }
+    
+    if (!calib.calibrated)
+        return info;
     
     // Calculate normalised directional tilts based on calibrated baselines
     // Approach similar to Mi.mu's directional vector calculations
-    float deltaX = current.accelX - calib.baselineX;
-    float deltaY = current.accelY - calib.baselineY;
-    float deltaZ = current.accelZ - calib.baselineZ;
+    float deltaX = history.latest(History::AccelX) - calib.baselineX;
+    float deltaY = history.latest(History::AccelY) - calib.baselineY;
+    float deltaZ = history.latest(History::AccelZ) - calib.baselineZ;
     
     // Normalise by standard deviations (Mi.mu statistical approach)
     // This gives direction relative to calibrated neutral position
-    if (calib.stdX > 0.001f) info.tiltX = std::clamp(deltaX / (3.0f * calib.stdX), -1.0f, 1.0f);
-    if (calib.stdY > 0.001f) info.tiltY = std::clamp(deltaY / (3.0f * calib.stdY), -1.0f, 1.0f);
-    if (calib.stdZ > 0.001f) info.tiltZ = std::clamp(deltaZ / (3.0f * calib.stdZ), -1.0f, 1.0f);
+    if (!usingDeviceFusion)
+    {
+        if (calib.stdX > 0.001f) info.tiltX = std::clamp(deltaX / (3.0f * calib.stdX), -1.0f, 1.0f);
+        if (calib.stdY > 0.001f) info.tiltY = std::clamp(deltaY / (3.0f * calib.stdY), -1.0f, 1.0f);
+        if (calib.stdZ > 0.001f) info.tiltZ = std::clamp(deltaZ / (3.0f * calib.stdZ), -1.0f, 1.0f);
+    }
     
     // Overall movement magnitude
     info.magnitude = std::sqrt(deltaX*deltaX + deltaY*deltaY + deltaZ*deltaZ);
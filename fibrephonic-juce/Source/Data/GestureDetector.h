@@ -9,19 +9,30 @@
 //======================================================================
 
 #pragma once
-#include <deque>
-#include <vector>
+#include <algorithm>
 #include <cmath>
-#include <numeric>
+#include <cstdint>
+#include <memory>
+#include <vector>
 #include "../Helpers.h"
+#include "SensorHistory.h"
+#include "SlidingExtrema.h"
+#include "SpectralFluxDetector.h"
+#include "WaveletEnergies.h"
 
 /**
- * Textile gesture detector focusing on calibration + tap detection
+ * Textile gesture detector focusing on calibration + tap and stroke detection
  *
  * Key components adapted from Mi.mu Gloves codebase:
  * - Calibration system: baseline mean/std calculation approach
  * - Tap detection: DrumDetector algorithm with threshold management
- * - Buffer management: circular buffer pattern for sensor data
+ * - Buffer management: circular buffer pattern for sensor data, stored as
+ *   contiguous per-axis lanes (SensorHistory) so window loops vectorise
+ *
+ * Single-threaded: everything here, settings and calibration included, is
+ * touched only by the thread running detection. GestureManager queues GUI
+ * commands and parameter changes to that thread and publishes the resulting
+ * calibration state back as snapshots.
  */
 class GestureDetector
 {
@@ -35,21 +46,79 @@ public:
         // Individual axis baselines for directional analysis
         float baselineX = 0.0f, baselineY = 0.0f, baselineZ = 0.0f;
         float stdX = 1.0f, stdY = 1.0f, stdZ = 1.0f;
+        
+        uint64_t sampleCount = 0;
+        float confidence = 0.0f;  // 0-1, see getCalibrationConfidence()
     };
 
-    GestureDetector(size_t bufferSize = 100);
+    /** Enough for the default 2 s history at the highest stream rate */
+    static constexpr size_t historyCapacity = 4096;
+    using History = SensorHistory<historyCapacity>;
+
+    /** Tunable settings, applied together between blocks */
+    struct Parameters
+    {
+        float tapThreshold = 5.0f;        // Gyro Z (deg/s); negative to trigger on the falling edge
+        float gyroThreshold = 5.0f;       // Secondary threshold
+        float accelTapThreshold = 0.3f;   // g, multi-axis accel lanes
+        bool driftTracking = false;       // See setDriftTracking()
+    };
+
+    /** @param historySeconds Length of sample history kept, independent of stream rate */
+    GestureDetector(float historySeconds = 2.0f);
+
+    /** A completed stroke across the textile */
+    struct StrokeEvent
+    {
+        Gestures::GestureType direction = Gestures::NONE;  // NONE unless a stroke just finished
+        float speed = 0.0f;            // Peak speed along the stroke (m/s), integrated from acceleration
+        float durationSeconds = 0.0f;
+        uint64_t startTimestamp = 0;   // Device time the stroke began (us)
+    };
 
     // Core functions
     void pushSample(const IMUData& sample);
     float detectTap();  // Returns velocity if tap detected, 0 otherwise
+    StrokeEvent detectStroke();  // Call once per sample; reports a stroke on the sample it ends
     
     // Calibration
     void startCalibration();
     void stopCalibration();
     void resetCalibration();
     bool isCalibrated() const { return calib.calibrated; }
+    bool isCalibrating() const { return calibrating; }
     Calibration getCalibration() const { return calib; }
     
+    /** Baseline from the samples gathered so far - O(1), valid mid-calibration */
+    Calibration getLiveCalibration() const;
+    
+    /**
+     * How trustworthy the current calibration pass is, 0-1: the fraction of the
+     * target duration gathered, scaled down by how much the sensor moved.
+     */
+    float getCalibrationConfidence() const { return calibrationConfidence; }
+    
+    /**
+     * Drift tracking: once calibrated, keep nudging the baseline towards the
+     * readings taken whenever the textile is still (getDirectionalInfo().isMoving
+     * is false), so slow drift as the fabric relaxes or warms up is absorbed
+     * without recalibrating. Movement never feeds the baseline.
+     */
+    void setDriftTracking(bool enabled) { driftTracking = enabled; }
+    bool isDriftTracking() const { return driftTracking; }
+    
+    /** Still samples folded into the baseline since it was last calibrated */
+    uint64_t getDriftSampleCount() const { return driftSamples; }
+    
+    // Timing - all times are device timestamps in microseconds
+    uint64_t getLastTimestamp() const { return lastTimestamp; }
+    uint64_t getLastTapTimestamp() const { return lastTapTimestamp; }
+    float getSampleRate() const { return sampleRate; }
+    uint64_t getLastStrokeTimestamp() const { return lastStrokeTimestamp; }
+    
+    /** True while detecting on gravity-free acceleration (from the device's or the host's AHRS) rather than the raw accelerometer */
+    bool isUsingDeviceFusion() const { return usingDeviceFusion; }
+    
     // Getters for Max/MSP streaming
     float getMagnitude() const;
     float getCalibratedMagnitude() const;
@@ -58,11 +127,72 @@ public:
     float getCalibratedZ() const;
     
     // Settings - drum detector style thresholds
-    void setTapThreshold(float v) { tapThreshold = v; }
+    void setTapThreshold(float v) { tapThreshold = v; updateTapLanes(); }
     void setGyroThreshold(float v) { gyroThreshold = v; }
+    void setAccelTapThreshold(float g) { accelTapThreshold = g; updateTapLanes(); }
+    
+    void setParameters(const Parameters& parameters);
+    Parameters getParameters() const;
+    
+    // Multi-axis taps - every enabled accel/gyro axis is checked each sample
+    // instead of gyro Z alone, at the same per-sample cost
+    static constexpr int numTapAxes = 6;  // AccelX..GyroZ, in History::Axis order
+    static constexpr uint32_t allTapAxes = (1u << numTapAxes) - 1;
     
-    // Access to buffer for analysis
-    const std::deque<IMUData>& getBuffer() const { return buffer; }
+    struct TapAxes
+    {
+        int firedAxis = -1;               // History::Axis that triggered, -1 before the first tap
+        float peaks[numTapAxes] = {};     // Peak deviation per axis over the tap (g or deg/s)
+    };
+    
+    void setMultiAxisTaps(bool enabled, uint32_t axisMask = allTapAxes);
+    bool isMultiAxisTaps() const { return multiAxisTaps; }
+    const TapAxes& getLastTapAxes() const { return lastTapAxes; }
+    
+    // Early taps - a tap is reported twice: a TAP_ONSET the moment the threshold
+    // is crossed, then the usual TAP with the peak velocity once it has passed.
+    // Both carry the same id so a sound can start at the crossing and be refined.
+    void setEarlyTaps(bool enabled) { earlyTaps = enabled; }
+    bool isEarlyTaps() const { return earlyTaps; }
+    bool isTapStarting() const { return tapStarting; }   // The last detectTap() crossed the threshold
+    uint32_t getTapId() const { return tapId; }          // Id of the tap in progress, or the last one
+    
+    // Spectral-flux onsets - an alternative to the tap threshold that also catches
+    // soft, grazing touches, from a short FFT of the acceleration magnitude
+    void setSpectralOnsets(bool enabled, int hopSize = 1);
+    bool isSpectralOnsets() const { return spectralOnsets; }
+    int getOnsetHopSize() const { return spectralOnsets ? onsetDetector->getHopSize() : 0; }
+    
+    /** A gesture found by processBlock(), tagged with the sample that produced it */
+    struct DetectionEvent
+    {
+        size_t offset = 0;             // Index of the sample within the block
+        uint64_t timestamp = 0;        // Device time of that sample (us)
+        Gestures::GestureType type = Gestures::NONE;  // TAP, ONSET or one of the STROKE_* directions
+        float velocity = 0.0f;         // Tap velocity, onset spectral flux, or stroke peak speed (m/s)
+        float durationSeconds = 0.0f;  // Strokes only
+        TapAxes tapAxes;               // Taps in multi-axis mode only
+        uint32_t tapId = 0;            // Taps and tap onsets; a tap's onset and its velocity share one
+    };
+    
+    /**
+     * Run a contiguous run of samples through tap and stroke detection - the same
+     * result as pushSample/detectTap/detectStroke per sample, with the per-call
+     * setup done once per block. Used to catch up after a stall and for offline
+     * analysis of recordings.
+     *
+     * Events are appended to the caller's vector in sample order; reserve it once
+     * (three per sample: tap or tap onset, onset and stroke) and clear it between
+     * blocks so it never reallocates.
+     * @returns Number of events appended
+     */
+    size_t processBlock(const IMUData* samples, size_t numSamples, std::vector<DetectionEvent>& events);
+    
+    // Access to history for analysis
+    const History& getHistory() const { return history; }
+    
+    /** Running wavelet detail energies per accel/gyro axis, updated with every sample */
+    const WaveletEnergies& getWaveletEnergies() const { return wavelets; }
     
     // Directional analysis (adapted from Mi.mu DirectionProcessor)
     struct DirectionalInfo
@@ -77,28 +207,147 @@ public:
     DirectionalInfo getDirectionalInfo() const;
 
 private:
-    std::deque<IMUData> buffer;
-    std::deque<IMUData> calibrationBuffer;
-    size_t maxBuffer;
+    History history;
+    float historySeconds;
     Calibration calib;
     bool calibrating = false;
     
+    // Welford running mean/variance - constant memory however long calibration runs
+    struct RunningStats
+    {
+        uint64_t count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        
+        void add(float value)
+        {
+            ++count;
+            const double delta = value - mean;
+            mean += delta / static_cast<double>(count);
+            m2 += delta * (value - mean);
+        }
+        
+        float getMean() const { return static_cast<float>(mean); }
+        float getStdDev() const { return count > 1 ? static_cast<float>(std::sqrt(m2 / static_cast<double>(count - 1))) : 0.0f; }
+    };
+    
+    RunningStats magnitudeStats, xStats, yStats, zStats;
+    
+    // Exponentially weighted mean/variance - follows the baseline with a fixed memory
+    struct DriftStats
+    {
+        float mean = 0.0f;
+        float variance = 0.0f;
+        float minStd = 0.0f;
+        
+        void seed(float baseline, float stdDev)
+        {
+            mean = baseline;
+            variance = stdDev * stdDev;
+            minStd = stdDev;
+        }
+        
+        void add(float value, float alpha)
+        {
+            const float delta = value - mean;
+            mean += alpha * delta;
+            variance = (1.0f - alpha) * (variance + alpha * delta * delta);
+        }
+        
+        // Only still samples get in, which trims the tails and biases the spread
+        // low; left alone that narrows the stillness gate until nothing passes.
+        // The noise estimate may grow from the manual calibration but not shrink.
+        float getStdDev() const { return std::max(minStd, std::sqrt(variance)); }
+    };
+    
+    DriftStats driftMagnitude, driftX, driftY, driftZ;
+    bool driftTracking = false;
+    uint64_t driftSamples = 0;
+    bool driftSeeded = false;
+    static constexpr float driftTimeConstantSeconds = 10.0f;  // Of stillness, not wall time
+    float calibrationConfidence = 0.0f;
+    static constexpr float calibrationTargetSeconds = 2.0f;  // Full confidence needs this much data
+    static constexpr float calibrationMaxStd = 0.1f;         // Magnitude std (g) at which confidence reaches 0
+    
     // Drum-style tap detection (adapted from Mi.mu DrumDetector)
     float tapThreshold = 5.f;      // Gyroscope threshold
     float gyroThreshold = 5.f;     // Secondary threshold
     float offThreshold = 5.f;
     bool tapPending = false;
-    int countDownTimer = 0;
-    float sampleRate = 100.0f;
-    std::deque<float> tapBuffer;      // Store recent gyro values for velocity calc
+    uint64_t refractoryEndTime = 0;           // No new tap may start before this time (us)
+    static constexpr uint64_t refractoryPeriod = 10000; // 10 ms, in us
+    SlidingExtrema<1024> tapPeak;     // Gyro peak since the last tap, for velocity
+    bool earlyTaps = false;
+    bool tapStarting = false;         // Set by the detectTap() call that opened a tap
+    float tapOnsetLevel = 0.0f;       // Level at the crossing, in tap velocity units
+    uint32_t tapId = 0;
+    static constexpr float tapWindowSeconds = 0.5f; // 800 samples at 1600 Hz
+    
+    // Multi-axis tap state, one lane per axis padded to a whole vector so the
+    // per-sample loops have a fixed trip count and compile to SIMD
+    static constexpr int tapLanes = 8;
+    bool multiAxisTaps = false;
+    uint32_t tapAxisMask = allTapAxes;
+    float accelTapThreshold = 0.3f;                      // g, deviation from the slow baseline
+    static constexpr float tapBaselineSeconds = 1.0f;    // Baseline tracking removes gravity and gyro bias
+    alignas(32) float laneEnabled[tapLanes] = {};
+    alignas(32) float laneThreshold[tapLanes] = {};
+    alignas(32) float laneOffThreshold[tapLanes] = {};
+    alignas(32) float laneBaseline[tapLanes] = {};
+    alignas(32) float lanePeak[tapLanes] = {};
+    alignas(32) float lanePending[tapLanes] = {};         // 1 while a lane is part of a tap, else 0
+    bool laneBaselineSet = false;
+    TapAxes lastTapAxes;
+    
+    // Spectral-flux onsets, allocated and planned at construction so switching them on never allocates
+    std::unique_ptr<SpectralFluxDetector> onsetDetector;
+    bool spectralOnsets = false;
+    static constexpr int onsetFFTSize = 32;               // 20 ms at 1600 Hz
+    static constexpr float onsetAdaptationSeconds = 1.0f; // Running flux statistics
+    
+    // Multi-level wavelet detail energies (texture / transient features)
+    WaveletEnergies wavelets;
+    static constexpr float waveletAveragingSeconds = 0.25f;
+    
+    // Stroke detection - constant-time state machine on the calibrated X/Y deltas.
+    // +X is a stroke to the right, +Y a stroke up, in the sensor frame.
+    float strokeFilteredX = 0.0f, strokeFilteredY = 0.0f;  // Low-passed deltas (g), rejects tap spikes
+    float strokeVelocityX = 0.0f, strokeVelocityY = 0.0f;  // Integrated since onset (m/s)
+    float strokePeakSpeed = 0.0f;
+    bool strokeActive = false;
+    uint64_t strokeStartTime = 0;
+    uint64_t lastStrokeTimestamp = 0;
+    static constexpr float strokeMinG = 0.05f;                // Onset never below this, whatever the noise
+    static constexpr float strokeSmoothingSeconds = 0.03f;
+    static constexpr uint64_t strokeMinDuration = 80000;      // 80 ms - shorter is a tap or a knock
+    static constexpr uint64_t strokeMaxDuration = 1500000;    // 1.5 s - longer is a lean or a tilt
+    static constexpr float strokeDominance = 1.5f;            // Main axis must beat the other by this
+    
+    // Timing, derived from device timestamps
+    float sampleRate = 100.0f;        // Running estimate, nominal until timestamps arrive
+    uint64_t lastTimestamp = 0;
+    uint64_t lastTapTimestamp = 0;
+    bool hasTimestamp = false;
+    bool rateMeasured = false;
+    
+    bool usingDeviceFusion = false;   // Frames carry AHRS output, from the device or host fusion
+    float orientationW = 1.0f, orientationX = 0.0f, orientationY = 0.0f, orientationZ = 0.0f;  // Latest AHRS quaternion
     
     // Helper functions
+    void updateTiming(IMUData& sample);
+    void updateWindowLengths();
+    void ingestSample(const IMUData& input);
+    void selectMotionSource(IMUData& sample);
     float magnitude(const IMUData& d) const;
-    float mean(const std::vector<float>& v) const;
-    float stddev(const std::vector<float>& v, float m) const;
-    void calculateCalibration();
+    float latestMagnitude() const;
+    void accumulateCalibration(const IMUData& sample);
+    void trackDrift();
+    void resetStroke();
     
     // Tap detection helpers (from Mi.mu DrumDetector)
     bool isThresholdExceeded(float input);
     float getMaxMagnitude();
+    float detectTapSingleAxis();
+    float detectTapMultiAxis();
+    void updateTapLanes();
 };
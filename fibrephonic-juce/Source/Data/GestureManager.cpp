@@ -7,10 +7,34 @@
 
 #include "GestureManager.h"
 #include "ConnectionManager.h"
+#include <algorithm>
 
-GestureManager::GestureManager()
+namespace
+{
+    // A replaced model or library is kept here until the processing thread has let go of it, and
+    // dropped by a later call once nothing else holds it, so it is always freed on the setter's
+    // thread rather than by the processing thread switching to its successor
+    template <typename T>
+    void retire(std::vector<std::shared_ptr<const T>>& retired, std::shared_ptr<const T> previous)
+    {
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                     [](const auto& object) { return object.use_count() == 1; }),
+                      retired.end());
+        
+        if (previous != nullptr)
+            retired.push_back(std::move(previous));
+    }
+}
+
+GestureManager::GestureManager(const juce::String& oscAddressPrefix)
+: juce::Thread("Gesture Processing Thread")
+, oscPrefix(oscAddressPrefix)
 {
     gestureDetector = std::make_unique<GestureDetector>();
+    
+    // At most a tap, an onset and a stroke per frame, so a full block never reallocates
+    detectionEvents.reserve(3 * MAX_BLOCK_FRAMES);
+    
     ensureOSCConnection();
 }
 
@@ -22,135 +46,365 @@ GestureManager::~GestureManager()
 void GestureManager::startPolling()
 {
     pollCount = 0;
+    tapCount = 0;
+    onsetCount = 0;
+    strokeCount = 0;
+    stats.resetPipeline();
     isPolling = true;
-    startTimerHz(POLLING_RATE_HZ);
+    startThread(juce::Thread::Priority::highest);
 }
 
 void GestureManager::stopPolling()
 {
     isPolling = false;
-    stopTimer();
+    signalThreadShouldExit();
+    
+    if (auto lockedManager = connectionManager.lock())
+    {
+        lockedManager->wakeConsumer();
+    }
+    
+    stopThread(2000);
 }
 
 void GestureManager::startCalibration()
 {
-    if (gestureDetector)
-    {
-        gestureDetector->startCalibration();
-        
-        // Send calibration start message to Max
-        if (ensureOSCConnection())
-        {
-            juce::OSCMessage msg("/calibration/start");
-            oscSender.send(msg);
-        }
-        
-        DBG("Started textile gesture calibration...");
-    }
+    queueCalibrationCommand(CalibrationCommand::start);
 }
 
 void GestureManager::stopCalibration()
 {
-    if (gestureDetector)
+    queueCalibrationCommand(CalibrationCommand::stop);
+}
+
+void GestureManager::resetCalibration()
+{
+    queueCalibrationCommand(CalibrationCommand::reset);
+}
+
+void GestureManager::queueCalibrationCommand(CalibrationCommand command)
+{
+    if (calibrationCommands.push(command))
+        ++calibrationCommandsIssued;
+    else
+        DBG("Calibration request dropped - the processing thread isn't keeping up");
+}
+
+void GestureManager::setDetectorParameters(const GestureDetector::Parameters& parameters)
+{
+    requestedParameters = parameters;
+    parameterExchange.publish(parameters);
+}
+
+// Runs on the processing thread between blocks, so the detector never sees a
+// request mid-sample and the OSC sender is only ever used from this thread
+void GestureManager::applyCalibrationCommand(CalibrationCommand command)
+{
+    ++calibrationCommandsApplied;
+    
+    switch (command)
     {
-        gestureDetector->stopCalibration();
+        case CalibrationCommand::start:
+        {
+            gestureDetector->startCalibration();
+            
+            // Send calibration start message to Max
+            if (ensureOSCConnection())
+            {
+                juce::OSCMessage msg(oscAddress("/calibration/start"));
+                oscSender.send(msg);
+            }
+            
+            DBG("Started textile gesture calibration...");
+            break;
+        }
         
-        // Send calibration data to Max
-        if (gestureDetector->isCalibrated() && ensureOSCConnection())
+        case CalibrationCommand::stop:
         {
-            auto calib = gestureDetector->getCalibration();
+            gestureDetector->stopCalibration();
             
-            juce::OSCMessage msg("/calibration/complete");
-            msg.addFloat32(calib.baselineMagnitude);
-            msg.addFloat32(calib.baselineStd);
-            msg.addFloat32(calib.baselineX);
-            msg.addFloat32(calib.baselineY);
-            msg.addFloat32(calib.baselineZ);
-            msg.addFloat32(calib.stdX);
-            msg.addFloat32(calib.stdY);
-            msg.addFloat32(calib.stdZ);
+            // Send calibration data to Max
+            if (gestureDetector->isCalibrated() && ensureOSCConnection())
+            {
+                auto calib = gestureDetector->getCalibration();
+                
+                juce::OSCMessage msg(oscAddress("/calibration/complete"));
+                msg.addFloat32(calib.baselineMagnitude);
+                msg.addFloat32(calib.baselineStd);
+                msg.addFloat32(calib.baselineX);
+                msg.addFloat32(calib.baselineY);
+                msg.addFloat32(calib.baselineZ);
+                msg.addFloat32(calib.stdX);
+                msg.addFloat32(calib.stdY);
+                msg.addFloat32(calib.stdZ);
+                msg.addFloat32(calib.confidence);
+                
+                oscSender.send(msg);
+            }
             
-            oscSender.send(msg);
+            DBG("Stopped textile gesture calibration");
+            break;
         }
         
-        DBG("Stopped textile gesture calibration");
+        case CalibrationCommand::reset:
+            gestureDetector->resetCalibration();
+            DBG("Reset textile gesture calibration");
+            break;
     }
 }
 
-bool GestureManager::isCalibrated() const
+void GestureManager::publishCalibrationState()
 {
-    return gestureDetector ? gestureDetector->isCalibrated() : false;
+    CalibrationState state;
+    state.calibration = gestureDetector->getCalibration();
+    state.calibrating = gestureDetector->isCalibrating();
+    state.confidence = gestureDetector->getCalibrationConfidence();
+    state.driftTracking = gestureDetector->isDriftTracking();
+    state.driftSamples = gestureDetector->getDriftSampleCount();
+    state.commandsApplied = calibrationCommandsApplied;
+    calibrationState.publish(state);
 }
 
-void GestureManager::timerCallback()
+void GestureManager::setClassifierModel(std::shared_ptr<const GestureClassifier::Model> model)
 {
-    if (isPolling)
+    const juce::ScopedLock sl(retiredLock);
+    retire(retiredModels, std::atomic_exchange(&pendingModel, std::move(model)));
+    modelChangeRequested = true;
+}
+
+void GestureManager::setTemplateLibrary(std::shared_ptr<const TemplateMatcher::Library> library)
+{
+    const juce::ScopedLock sl(retiredLock);
+    retire(retiredLibraries, std::atomic_exchange(&pendingLibrary, std::move(library)));
+    libraryChangeRequested = true;
+}
+
+void GestureManager::setSensorFilters(float highPassHz, float lowPassHz, int order)
+{
+    highPassRequested = juce::jmax(0.0f, highPassHz);
+    lowPassRequested = juce::jmax(0.0f, lowPassHz);
+    filterOrderRequested = order;
+    filterChangeRequested = true;
+}
+
+void GestureManager::run()
+{
+    while (!threadShouldExit())
     {
-        pollGestures();
+        // Check if connection manager is still valid
+        auto lockedManager = connectionManager.lock();
+        if (!lockedManager)
+        {
+            break;
+        }
+        
+        // Sleep until Connection queues a frame, then process it immediately
+        if (!lockedManager->waitForSamples(SAMPLE_WAIT_TIMEOUT_MS))
+        {
+            continue;
+        }
+        
+        pollCount++;
+        
+        // Drain every frame queued since the last wake-up so none are dropped or repeated,
+        // a block at a time so a backlog is caught up in a few passes
+        size_t numFrames = 0;
+        while (!threadShouldExit()
+               && (numFrames = lockedManager->popSamples(pollBlock.data(), pollBlock.size())) > 0)
+        {
+            processBlock(pollBlock.data(), numFrames);
+        }
+        
+        stats.setSamplesDropped(lockedManager->getSampleOverruns());
     }
+    
+    isPolling = false;
 }
 
-void GestureManager::pollGestures()
+void GestureManager::processBlock(const IMUData* frames, size_t numFrames)
 {
-    pollCount++;
+    if (numFrames == 0)
+        return;
     
-    // Get latest sensor data from connection manager
-    if (!getSensorDataFromConnection())
-        return; // No valid data available
+    // Host fusion and filtering work on a block-sized copy, so longer runs are taken a block at a time
+    if (numFrames > MAX_BLOCK_FRAMES)
+    {
+        for (size_t first = 0; first < numFrames; first += MAX_BLOCK_FRAMES)
+            processBlock(frames + first, juce::jmin(MAX_BLOCK_FRAMES, numFrames - first));
+        
+        return;
+    }
     
-    IMUData imuData(
-        sensorData.accelX, sensorData.accelY, sensorData.accelZ,
-        sensorData.gyroX, sensorData.gyroY, sensorData.gyroZ,
-        sensorData.magX, sensorData.magY, sensorData.magZ
-    );
+    // Detector settings are only touched here, on the thread that runs it
+    if (parameterExchange.update())
+        gestureDetector->setParameters(parameterExchange.get());
     
-    // Update detector and check for tap (Mi.mu drum-detector based)
-    gestureDetector->pushSample(imuData);
-    lastTapVelocity = gestureDetector->detectTap(); // Returns velocity or 0
+    CalibrationCommand command;
+    while (calibrationCommands.pop(command))
+        applyCalibrationCommand(command);
     
-    // Send ALL data via OSC at refresh rate
-    sendDataViaOSC();
-}
-
-bool GestureManager::getSensorDataFromConnection()
-{
-    // Check if connection manager is still valid
-    auto lockedManager = connectionManager.lock();
-    if (!lockedManager)
+    if (multiAxisTapsRequested.load() != gestureDetector->isMultiAxisTaps())
+        gestureDetector->setMultiAxisTaps(multiAxisTapsRequested.load());
+    
+    if (earlyTapsRequested.load() != gestureDetector->isEarlyTaps())
+        gestureDetector->setEarlyTaps(earlyTapsRequested.load());
+    
+    const int onsetHop = spectralOnsetHopRequested.load(); // 0 = off
+    if (onsetHop != gestureDetector->getOnsetHopSize())
+        gestureDetector->setSpectralOnsets(onsetHop > 0, onsetHop);
+    
+    if (modelChangeRequested.exchange(false))
+    {
+        classifier.setModel(std::atomic_load(&pendingModel));
+        lastClassIndex = -1;
+        lastClassConfidence = 0.0f;
+    }
+    
+    if (libraryChangeRequested.exchange(false))
+    {
+        matcher.setLibrary(std::atomic_load(&pendingLibrary));
+        lastMatchLabel = -1;
+        lastMatchDistance = 0.0f;
+    }
+    
+    if (hostFusionRequested.load() != hostFusionActive)
+    {
+        hostFusionActive = !hostFusionActive;
+        hostFusion.reset();
+    }
+    
+    if (filterChangeRequested.exchange(false))
+    {
+        SensorFilterBank::Settings filterSettings;
+        filterSettings.highPassHz = highPassRequested.load();
+        filterSettings.lowPassHz = lowPassRequested.load();
+        filterSettings.order = filterOrderRequested.load();
+        sensorFilters.setSettings(filterSettings);
+        gestureDetector->resetCalibration();
+    }
+    
+    // Designed for the rate measured up to the last block; only a real change redesigns
+    sensorFilters.prepare(gestureDetector->getSampleRate());
+    
+    const auto detectorStart = juce::Time::getHighResolutionTicks();
+    
+    if (hostFusionActive || sensorFilters.isActive())
+    {
+        std::copy(frames, frames + numFrames, stagedBlock.begin());
+        frames = stagedBlock.data();
+    }
+    
+    // Frames already carrying the device's own AHRS output pass through untouched
+    if (hostFusionActive)
+    {
+        for (size_t i = 0; i < numFrames; ++i)
+            if (!stagedBlock[i].hasFusion)
+                hostFusion.process(stagedBlock[i]);
+    }
+    
+    // OSC sensor streams stay unfiltered; only detection sees the band-limited axes
+    sensorData = frames[numFrames - 1];
+    
+    if (sensorFilters.isActive())
+        sensorFilters.process(stagedBlock.data(), numFrames);
+    
+    // Tap (Mi.mu drum-detector based) and stroke detection over the whole block
+    detectionEvents.clear();
+    gestureDetector->processBlock(frames, numFrames, detectionEvents);
+    
+    // The window is kept current even without a model, so one loaded mid-stream classifies at once
+    const bool classified = classifier.update(*gestureDetector, numFrames);
+    const bool matched = matcher.update(*gestureDetector, numFrames);
+    
+    const auto detectorTicks = juce::Time::getHighResolutionTicks() - detectorStart;
+    stats.recordBlock(numFrames, static_cast<uint64_t>(juce::Time::highResolutionTicksToSeconds(detectorTicks) * 1.0e9));
+    
+    measuredSampleRate = gestureDetector->getSampleRate();
+    
+    float blockTapVelocity = 0.0f;
+    for (const auto& event : detectionEvents)
     {
-        if (isPolling)
+        if (event.type == Gestures::TAP)
         {
-            stopPolling();
+            ++tapCount;
+            blockTapVelocity = event.velocity;
+        }
+        else if (event.type == Gestures::ONSET)
+        {
+            ++onsetCount;
+        }
+        else if (event.type == Gestures::TAP_ONSET)
+        {
+            // Counted once, by its TAP
+        }
+        else
+        {
+            ++strokeCount;
+            lastStrokeDirection = event.type;
+            lastStrokeSpeed = event.velocity;
         }
-        return false;
     }
+    lastTapVelocity = blockTapVelocity; // Latest tap in this block, or 0
     
-    // Check if we have a valid connection
-    if (!lockedManager->getIsConnected())
+    // Classes are sent as they change rather than every hop
+    if (classified)
     {
-        return false;
+        const auto& prediction = classifier.getPrediction();
+        lastClassConfidence = prediction.confidence;
+        
+        if (prediction.classIndex != lastClassIndex.exchange(prediction.classIndex))
+            sendClassViaOSC(prediction);
     }
     
-    try
+    // Template matches stream every hop, like gesture events, so Max can apply its own distance threshold
+    if (matched)
     {
-        // Get latest sensor readings - these are atomic operations so thread-safe
-        sensorData.accelX = static_cast<float>(lockedManager->getAccelerationX());
-        sensorData.accelY = static_cast<float>(lockedManager->getAccelerationY());
-        sensorData.accelZ = static_cast<float>(lockedManager->getAccelerationZ());
+        const auto& match = matcher.getMatch();
+        lastMatchLabel = match.labelIndex;
+        lastMatchDistance = match.distance;
+        sendMatchViaOSC(match);
+    }
+    
+    // Continuous streams are decimated to the output rate so high stream rates
+    // don't flood the network, and only ever describe the newest frame
+    const uint64_t now = gestureDetector->getLastTimestamp();
+    const uint64_t outputInterval = 1000000 / static_cast<uint64_t>(outputRateHz.load());
+    bool continuousDue = now < lastContinuousOutputTime
+                      || now - lastContinuousOutputTime >= outputInterval;
+    
+    if (continuousDue)
+        lastContinuousOutputTime = now;
+    
+    // Gestures go out in one bundle per frame they were detected on, stamped with
+    // that frame's device time; the newest frame's bundle also carries the streams
+    for (size_t first = 0; first < detectionEvents.size();)
+    {
+        size_t last = first + 1;
+        while (last < detectionEvents.size() && detectionEvents[last].offset == detectionEvents[first].offset)
+            ++last;
         
-        sensorData.gyroX = static_cast<float>(lockedManager->getGyroscopeX());
-        sensorData.gyroY = static_cast<float>(lockedManager->getGyroscopeY());
-        sensorData.gyroZ = static_cast<float>(lockedManager->getGyroscopeZ());
+        const bool onNewestFrame = detectionEvents[first].offset == numFrames - 1;
+        sendDataViaOSC(detectionEvents[first].timestamp, continuousDue && onNewestFrame,
+                       detectionEvents.data() + first, last - first);
         
-        sensorData.magX = static_cast<float>(lockedManager->getMagnetometerX());
-        sensorData.magY = static_cast<float>(lockedManager->getMagnetometerY());
-        sensorData.magZ = static_cast<float>(lockedManager->getMagnetometerZ());
+        if (onNewestFrame)
+            continuousDue = false;
         
-        return true;
+        first = last;
     }
-    catch (...)
+    
+    if (continuousDue)
+        sendDataViaOSC(now, true, nullptr, 0);
+    
+    publishCalibrationState();
+    
+    // Metrics run on host time so they keep flowing even if the device clock stalls
+    const auto nowMs = juce::Time::getMillisecondCounter();
+    if (nowMs - lastStatsOutputMs >= STATS_INTERVAL_MS)
     {
-        return false;
+        lastStatsOutputMs = nowMs;
+        sendStatsViaOSC();
+        sendDriftViaOSC();
     }
 }
 
@@ -175,7 +429,28 @@ bool GestureManager::ensureOSCConnection()
     }
 }
 
-void GestureManager::sendDataViaOSC()
+juce::OSCTimeTag GestureManager::getTimeTag(uint64_t deviceTimestamp)
+{
+    // Anchor the device clock to the host clock on the first frame (and whenever
+    // the device clock restarts), then advance purely on device time so the tags
+    // carry the sensor's own sample spacing rather than network/scheduling jitter
+    if (!timeOriginSet || deviceTimestamp < deviceTimeOrigin)
+    {
+        deviceTimeOrigin = deviceTimestamp;
+        hostTimeTagOrigin = juce::OSCTimeTag(juce::Time::getCurrentTime()).getRawTimeTag();
+        timeOriginSet = true;
+    }
+    
+    // Microseconds to 32.32 fixed-point NTP seconds
+    const uint64_t elapsed = deviceTimestamp - deviceTimeOrigin;
+    const uint64_t seconds = elapsed / 1000000;
+    const uint64_t fraction = ((elapsed % 1000000) << 32) / 1000000;
+    
+    return juce::OSCTimeTag(hostTimeTagOrigin + (seconds << 32) + fraction);
+}
+
+void GestureManager::sendDataViaOSC(uint64_t timestamp, bool includeContinuous,
+                                    const GestureDetector::DetectionEvent* frameEvents, size_t numEvents)
 {
     if (!ensureOSCConnection())
     {
@@ -184,62 +459,143 @@ void GestureManager::sendDataViaOSC()
     
     try
     {
-        // Raw sensor data (existing streams for compatibility)
-        juce::OSCMessage accMessage("/sensor/acc");
-        accMessage.addFloat32(sensorData.accelX);
-        accMessage.addFloat32(sensorData.accelY);
-        accMessage.addFloat32(sensorData.accelZ);
-        
-        juce::OSCMessage gyroMessage("/sensor/gyro");
-        gyroMessage.addFloat32(sensorData.gyroX);
-        gyroMessage.addFloat32(sensorData.gyroY);
-        gyroMessage.addFloat32(sensorData.gyroZ);
-        
-        juce::OSCMessage magMessage("/sensor/mag");
-        magMessage.addFloat32(sensorData.magX);
-        magMessage.addFloat32(sensorData.magY);
-        magMessage.addFloat32(sensorData.magZ);
+        // Everything derived from this frame goes out in one bundle stamped with its device time
+        juce::OSCBundle bundle(getTimeTag(timestamp));
         
         // Enhanced data for Max/MSP analysis (only if calibrated)
-        if (gestureDetector->isCalibrated())
+        if (includeContinuous && gestureDetector->isCalibrated())
         {
-            juce::OSCMessage calibratedMessage("/sensor/calibrated");
+            juce::OSCMessage calibratedMessage(oscAddress("/sensor/calibrated"));
             calibratedMessage.addFloat32(gestureDetector->getCalibratedMagnitude());
             calibratedMessage.addFloat32(gestureDetector->getCalibratedX());
             calibratedMessage.addFloat32(gestureDetector->getCalibratedY());
             calibratedMessage.addFloat32(gestureDetector->getCalibratedZ());
             
-            juce::OSCMessage magnitudeMessage("/sensor/magnitude");
+            juce::OSCMessage magnitudeMessage(oscAddress("/sensor/magnitude"));
             magnitudeMessage.addFloat32(gestureDetector->getMagnitude());
             
             // Continuous directional information (adapted from Mi.mu DirectionProcessor)
             auto directionalInfo = gestureDetector->getDirectionalInfo();
-            juce::OSCMessage directionMessage("/sensor/direction");
+            juce::OSCMessage directionMessage(oscAddress("/sensor/direction"));
             directionMessage.addFloat32(directionalInfo.tiltX);      // -1 to 1, normalised tilt
             directionMessage.addFloat32(directionalInfo.tiltY);      // -1 to 1, normalised tilt
             directionMessage.addFloat32(directionalInfo.tiltZ);      // -1 to 1, normalised tilt
             directionMessage.addFloat32(directionalInfo.magnitude);  // Overall movement magnitude
             directionMessage.addInt32(directionalInfo.isMoving ? 1 : 0); // Movement flag
             
-            if (!oscSender.send(calibratedMessage) || !oscSender.send(magnitudeMessage) ||
-                !oscSender.send(directionMessage))
-                oscConnected = false;
+            bundle.addElement(calibratedMessage);
+            bundle.addElement(magnitudeMessage);
+            bundle.addElement(directionMessage);
         }
         
-        // Tap detection with velocity (Mi.mu drum-detector style)
-        if (lastTapVelocity > 0.0f)
+        for (size_t i = 0; i < numEvents; ++i)
         {
-            juce::OSCMessage tapMessage("/gesture/tap");
-            tapMessage.addFloat32(lastTapVelocity);
-            tapMessage.addInt32(1); // Binary flag for Max trigger
+            const auto& event = frameEvents[i];
             
-            if (!oscSender.send(tapMessage))
-                oscConnected = false;
+            if (event.type == Gestures::TAP)
+            {
+                // Tap detection with velocity (Mi.mu drum-detector style)
+                juce::OSCMessage tapMessage(oscAddress("/gesture/tap"));
+                tapMessage.addFloat32(event.velocity);
+                tapMessage.addInt32(1); // Binary flag for Max trigger
+                tapMessage.addInt32(static_cast<juce::int32>(event.tapId)); // Matches its /gesture/tap/onset
+                
+                bundle.addElement(tapMessage);
+                
+                // Which axis fired, and the peak on each (accel in g, gyro in deg/s)
+                if (event.tapAxes.firedAxis >= 0)
+                {
+                    juce::OSCMessage axesMessage(oscAddress("/gesture/tap/axes"));
+                    axesMessage.addInt32(event.tapAxes.firedAxis);
+                    for (float peak : event.tapAxes.peaks)
+                        axesMessage.addFloat32(peak);
+                    
+                    bundle.addElement(axesMessage);
+                }
+            }
+            else if (event.type == Gestures::TAP_ONSET)
+            {
+                // Threshold crossing of a tap still in progress - start the sound now,
+                // refine it when the /gesture/tap with the same id brings the peak
+                juce::OSCMessage tapOnsetMessage(oscAddress("/gesture/tap/onset"));
+                tapOnsetMessage.addInt32(static_cast<juce::int32>(event.tapId));
+                tapOnsetMessage.addFloat32(event.velocity);       // Level at the crossing, tap velocity units
+                
+                bundle.addElement(tapOnsetMessage);
+            }
+            else if (event.type == Gestures::ONSET)
+            {
+                // Spectral-flux onset - also fires for touches too soft for a tap
+                juce::OSCMessage onsetMessage(oscAddress("/gesture/onset"));
+                onsetMessage.addFloat32(event.velocity);          // Spectral flux
+                
+                bundle.addElement(onsetMessage);
+            }
+            else
+            {
+                // Stroke, reported on the frame it ends
+                juce::OSCMessage strokeMessage(oscAddress("/gesture/stroke"));
+                strokeMessage.addString(juce::String(Gestures::getGestureName(event.type)));
+                strokeMessage.addInt32(static_cast<juce::int32>(event.type));
+                strokeMessage.addFloat32(event.velocity);          // m/s
+                strokeMessage.addFloat32(event.durationSeconds);
+                
+                bundle.addElement(strokeMessage);
+            }
+        }
+        
+        // Raw sensor data (existing streams for compatibility)
+        if (includeContinuous)
+        {
+            juce::OSCMessage accMessage(oscAddress("/sensor/acc"));
+            accMessage.addFloat32(sensorData.accelX);
+            accMessage.addFloat32(sensorData.accelY);
+            accMessage.addFloat32(sensorData.accelZ);
+            
+            juce::OSCMessage gyroMessage(oscAddress("/sensor/gyro"));
+            gyroMessage.addFloat32(sensorData.gyroX);
+            gyroMessage.addFloat32(sensorData.gyroY);
+            gyroMessage.addFloat32(sensorData.gyroZ);
+            
+            juce::OSCMessage magMessage(oscAddress("/sensor/mag"));
+            magMessage.addFloat32(sensorData.magX);
+            magMessage.addFloat32(sensorData.magY);
+            magMessage.addFloat32(sensorData.magZ);
+            
+            bundle.addElement(accMessage);
+            bundle.addElement(gyroMessage);
+            bundle.addElement(magMessage);
+            
+            // Wavelet detail energies: ax, ay, az, gx, gy, gz, each finest level first
+            const auto& wavelets = gestureDetector->getWaveletEnergies();
+            juce::OSCMessage waveletMessage(oscAddress("/sensor/wavelet"));
+            for (int axis = 0; axis < WaveletEnergies::numAxes; ++axis)
+                for (int level = 0; level < wavelets.getNumLevels(); ++level)
+                    waveletMessage.addFloat32(wavelets.getEnergy(axis, level));
+            
+            bundle.addElement(waveletMessage);
+            
+            // On-device AHRS output, when streaming
+            if (sensorData.hasFusion)
+            {
+                juce::OSCMessage quaternionMessage(oscAddress("/sensor/quaternion"));
+                quaternionMessage.addFloat32(sensorData.quatW);
+                quaternionMessage.addFloat32(sensorData.quatX);
+                quaternionMessage.addFloat32(sensorData.quatY);
+                quaternionMessage.addFloat32(sensorData.quatZ);
+                
+                juce::OSCMessage linearMessage(oscAddress("/sensor/linear"));
+                linearMessage.addFloat32(sensorData.linearAccelX);
+                linearMessage.addFloat32(sensorData.linearAccelY);
+                linearMessage.addFloat32(sensorData.linearAccelZ);
+                
+                bundle.addElement(quaternionMessage);
+                bundle.addElement(linearMessage);
+            }
         }
         
         // Send all messages
-        if (!oscSender.send(accMessage) || !oscSender.send(gyroMessage) ||
-            !oscSender.send(magMessage))
+        if (!oscSender.send(bundle))
         {
             oscConnected = false;
         }
@@ -253,3 +609,103 @@ void GestureManager::sendDataViaOSC()
         oscConnected = false;
     }
 }
+
+void GestureManager::sendDriftViaOSC()
+{
+    // Only once drift tracking has actually moved the baseline since the last report
+    const uint64_t driftSamples = gestureDetector->getDriftSampleCount();
+    if (!gestureDetector->isDriftTracking() || driftSamples == lastDriftSamplesSent)
+        return;
+    
+    lastDriftSamplesSent = driftSamples;
+    
+    if (!ensureOSCConnection())
+    {
+        return;
+    }
+    
+    // Same layout as /calibration/complete, minus the confidence
+    const auto calib = gestureDetector->getCalibration();
+    juce::OSCMessage msg(oscAddress("/calibration/drift"));
+    msg.addFloat32(calib.baselineMagnitude);
+    msg.addFloat32(calib.baselineStd);
+    msg.addFloat32(calib.baselineX);
+    msg.addFloat32(calib.baselineY);
+    msg.addFloat32(calib.baselineZ);
+    msg.addFloat32(calib.stdX);
+    msg.addFloat32(calib.stdY);
+    msg.addFloat32(calib.stdZ);
+    
+    if (!oscSender.send(msg))
+    {
+        oscConnected = false;
+    }
+}
+
+void GestureManager::sendClassViaOSC(const GestureClassifier::Prediction& prediction)
+{
+    const auto* model = classifier.getModel();
+    if (model == nullptr || prediction.classIndex < 0 || !ensureOSCConnection())
+    {
+        return;
+    }
+    
+    juce::OSCBundle bundle(getTimeTag(prediction.timestamp));
+    juce::OSCMessage classMessage(oscAddress("/gesture/class"));
+    classMessage.addString(model->labels[prediction.classIndex]);
+    classMessage.addInt32(prediction.classIndex);
+    classMessage.addFloat32(prediction.confidence);
+    bundle.addElement(classMessage);
+    
+    if (!oscSender.send(bundle))
+    {
+        oscConnected = false;
+    }
+}
+
+void GestureManager::sendMatchViaOSC(const TemplateMatcher::Match& match)
+{
+    const auto* library = matcher.getLibrary();
+    if (library == nullptr || match.labelIndex < 0 || !ensureOSCConnection())
+    {
+        return;
+    }
+    
+    juce::OSCBundle bundle(getTimeTag(match.timestamp));
+    juce::OSCMessage matchMessage(oscAddress("/gesture/match"));
+    matchMessage.addString(library->labels[match.labelIndex]);
+    matchMessage.addInt32(match.labelIndex);
+    matchMessage.addFloat32(match.distance);
+    bundle.addElement(matchMessage);
+    
+    if (!oscSender.send(bundle))
+    {
+        oscConnected = false;
+    }
+}
+
+void GestureManager::sendStatsViaOSC()
+{
+    const auto snapshot = stats.getSnapshot();
+    stats.resetPeak();
+    
+    if (!ensureOSCConnection())
+    {
+        return;
+    }
+    
+    juce::OSCMessage statsMessage(oscAddress("/stats"));
+    statsMessage.addInt32(static_cast<juce::int32>(snapshot.linkDataRate));      // bytes/s
+    statsMessage.addInt32(static_cast<juce::int32>(snapshot.linkMessageRate));   // messages/s
+    statsMessage.addInt32(static_cast<juce::int32>(snapshot.linkErrorRate));     // decode errors/s
+    statsMessage.addInt64(static_cast<juce::int64>(snapshot.samplesProcessed));  // Running totals - these would
+    statsMessage.addInt64(static_cast<juce::int64>(snapshot.samplesDropped));    // wrap an int32 within weeks
+    statsMessage.addFloat32(snapshot.meanDetectorMicros);
+    statsMessage.addFloat32(snapshot.maxDetectorMicros);                         // worst frame this interval
+    statsMessage.addFloat32(measuredSampleRate.load());
+    
+    if (!oscSender.send(statsMessage))
+    {
+        oscConnected = false;
+    }
+}
@@ -1,23 +1,41 @@
 /**
  * @file GestureManager.h
  * @brief Manages textile gesture detection with calibration support
- * Uses drum-detector style approach for material interactions
+ * Uses drum-detector style approach for material interactions.
+ * Detection and OSC output run on a dedicated high-priority thread that is
+ * woken by each incoming frame, so GUI load never delays a trigger.
+ * The GUI never touches the detector: calibration requests and parameters are
+ * handed to the processing thread without locks and applied between blocks,
+ * and the calibration comes back as a snapshot published after each block.
  */
 
 #pragma once
 
 #include <JuceHeader.h>
+#include <array>
 #include <memory>
 #include <atomic>
+#include <vector>
 #include "GestureDetector.h"
+#include "PipelineStats.h"
+#include "SampleRing.h"
+#include "SnapshotExchange.h"
+#include "MadgwickFilter.h"
+#include "SensorFilterBank.h"
+#include "Training/GestureClassifier.h"
+#include "Training/TemplateMatcher.h"
 #include "../Helpers.h"
 
 class ConnectionManager;
 
-class GestureManager : private juce::Timer
+class GestureManager : private juce::Thread
 {
 public:
-    GestureManager();
+    /**
+     * @param oscAddressPrefix Prepended to every OSC address (e.g. "/device/<serial>")
+     *                         so several managers can share one Max patch
+     */
+    explicit GestureManager(const juce::String& oscAddressPrefix = {});
     ~GestureManager();
     
     void setConnectionManager(std::shared_ptr<ConnectionManager> connectionManagerInstance)
@@ -28,24 +46,121 @@ public:
     // Core functions
     void startPolling();
     void stopPolling();
+    bool getIsPolling() const { return isPolling.load(); }
     
-    // Calibration
+    /** @brief Most frames handed to processBlock() at once; callers drain their queues in runs of this size */
+    static constexpr size_t MAX_BLOCK_FRAMES = 64;
+    
+    /** @brief Run a run of consecutive frames through detection and OSC output on the calling thread.
+     *  Used by the polling thread, and directly by Ximu3DeviceManager's device threads. A backlog
+     *  after a stall is handled in one pass: every gesture is still sent, time-tagged with its
+     *  own frame, while continuous streams describe only the newest frame. */
+    void processBlock(const IMUData* frames, size_t numFrames);
+    
+    /** @brief Single-frame form of processBlock() */
+    void processSample(const IMUData& frame) { processBlock(&frame, 1); }
+    
+    // Calibration - requests are queued to the processing thread and take effect between blocks
     void startCalibration();
     void stopCalibration();
-    bool isCalibrated() const;
+    void resetCalibration();
+    
+    /** @brief The detector's calibration as of the last processed block */
+    struct CalibrationState
+    {
+        GestureDetector::Calibration calibration;
+        bool calibrating = false;
+        float confidence = 0.0f;          ///< Of the pass in progress, see GestureDetector::getCalibrationConfidence()
+        bool driftTracking = false;
+        uint64_t driftSamples = 0;
+        uint32_t commandsApplied = 0;     ///< Calibration requests handled so far
+    };
+    
+    /** @brief Newest published calibration state - message thread only (the snapshot's single reader) */
+    const CalibrationState& getCalibrationState() const { return calibrationState.latest(); }
+    bool isCalibrated() const { return getCalibrationState().calibration.calibrated; }
+    
+    /** @brief True once the processing thread has applied every calibration request made so far */
+    bool isCalibrationSettled() const { return getCalibrationState().commandsApplied == calibrationCommandsIssued; }
+    
+    /** @brief Replace the detector's thresholds and drift tracking as a unit, between blocks - message thread only */
+    void setDetectorParameters(const GestureDetector::Parameters& parameters);
+    const GestureDetector::Parameters& getDetectorParameters() const { return requestedParameters; }
+    
+    /** @brief Owned by the processing thread - only touch it from there, or while nothing is being processed */
     GestureDetector* getDetector() { return gestureDetector.get(); }
     
     // For UI feedback
-    float getLastTapVelocity() const { return lastTapVelocity; }
+    float getLastTapVelocity() const { return lastTapVelocity.load(); }
+    float getMeasuredSampleRate() const { return measuredSampleRate.load(); }
+    
+    /** @brief Taps detected since polling last started - used for replay regression checks */
+    uint64_t getTapCount() const { return tapCount.load(); }
+    
+    /** @brief Most recent stroke, for UI feedback */
+    Gestures::GestureType getLastStrokeDirection() const { return static_cast<Gestures::GestureType>(lastStrokeDirection.load()); }
+    float getLastStrokeSpeed() const { return lastStrokeSpeed.load(); }
+    uint64_t getStrokeCount() const { return strokeCount.load(); }
+    
+    /** @brief Spectral-flux onsets detected since polling last started */
+    uint64_t getOnsetCount() const { return onsetCount.load(); }
+    
+    /** @brief Detect taps on all six accel/gyro axes rather than gyro Z only.
+     *  Takes effect on the processing thread at the next frame. */
+    void setMultiAxisTaps(bool enabled) { multiAxisTapsRequested.store(enabled); }
+    
+    /** @brief Also send /gesture/tap/onset the moment a tap crosses its threshold, ahead of the
+     *  /gesture/tap carrying its peak velocity; both carry the tap's id. Takes effect at the next frame. */
+    void setEarlyTaps(bool enabled) { earlyTapsRequested.store(enabled); }
+    
+    /** @brief Run the spectral-flux onset detector alongside taps, transforming every hopSize frames.
+     *  Takes effect on the processing thread at the next frame. */
+    void setSpectralOnsets(bool enabled, int hopSize = 1) { spectralOnsetHopRequested.store(enabled ? juce::jmax(1, hopSize) : 0); }
+    
+    /** @brief Classify the live window with a model trained from GestureRecorder CSVs (nullptr to stop).
+     *  Takes effect on the processing thread at the next frame; the model may be shared between managers. */
+    void setClassifierModel(std::shared_ptr<const GestureClassifier::Model> model);
+    
+    /** @brief Latest classification: an index into the model's labels (-1 for none) and the share of neighbours that agreed */
+    int getClassIndex() const { return lastClassIndex.load(); }
+    float getClassConfidence() const { return lastClassConfidence.load(); }
+    
+    /** @brief Match the live window against recorded DTW templates every hop (nullptr to stop).
+     *  Takes effect on the processing thread at the next frame; the library may be shared between managers. */
+    void setTemplateLibrary(std::shared_ptr<const TemplateMatcher::Library> library);
+    
+    /** @brief Latest template match: an index into the library's labels (-1 for none) and its distance */
+    int getMatchLabelIndex() const { return lastMatchLabel.load(); }
+    float getMatchDistance() const { return lastMatchDistance.load(); }
+    
+    /** @brief Estimate orientation on the host for frames that arrive without the device's AHRS output,
+     *  and detect on the resulting gravity-free acceleration. Takes effect on the processing thread at the next frame. */
+    void setHostFusion(bool enabled) { hostFusionRequested.store(enabled); }
+    
+    /** @brief Band-limit every axis before detection: Butterworth high-pass and/or low-pass of order 2 or 4
+     *  (0 Hz = off). Takes effect on the processing thread at the next frame and drops the calibration,
+     *  whose baselines were taken through the old response. */
+    void setSensorFilters(float highPassHz, float lowPassHz, int order = 2);
+    
+    /** @brief Rate for continuous OSC streams; gesture events are always sent immediately */
+    void setOutputRate(int rateHz) { outputRateHz.store(juce::jmax(1, rateHz)); }
+    
+    /** @brief Live link and processing metrics, also streamed to OSC /stats once a second */
+    PipelineStats& getStats() { return stats; }
+    const PipelineStats& getStats() const { return stats; }
 
 private:
-    static constexpr int POLLING_RATE_HZ = 100;
+    /** Upper bound on how long the thread sleeps without a frame - only affects shutdown latency */
+    static constexpr int SAMPLE_WAIT_TIMEOUT_MS = 20;
+    
+    static constexpr juce::uint32 STATS_INTERVAL_MS = 1000;
     
     std::unique_ptr<GestureDetector> gestureDetector;
     std::weak_ptr<ConnectionManager> connectionManager;
     
     // OSC Communication
     juce::OSCSender oscSender;
+    juce::String oscPrefix;
     juce::String oscHost = "192.169.1.2";
     int oscPort = 5006;
     bool oscConnected = false;
@@ -54,21 +169,83 @@ private:
     // State
     std::atomic<int> pollCount{0};
     std::atomic<bool> isPolling{false};
-    float lastTapVelocity = 0.0f;
+    std::atomic<float> lastTapVelocity{0.0f};
+    std::atomic<float> measuredSampleRate{0.0f};
+    std::atomic<uint64_t> tapCount{0};
+    std::atomic<int> lastStrokeDirection{Gestures::NONE};
+    std::atomic<float> lastStrokeSpeed{0.0f};
+    std::atomic<uint64_t> strokeCount{0};
+    std::atomic<uint64_t> onsetCount{0};
+    std::vector<GestureDetector::DetectionEvent> detectionEvents;  ///< Reused for every block
+    std::array<IMUData, MAX_BLOCK_FRAMES> pollBlock;              ///< Frames drained by the polling thread
+    std::array<IMUData, MAX_BLOCK_FRAMES> stagedBlock;            ///< Block copy carrying host fusion and filter output
+    MadgwickFilter hostFusion;
+    bool hostFusionActive = false;
+    std::atomic<bool> hostFusionRequested{false};
+    SensorFilterBank sensorFilters;
+    std::atomic<float> highPassRequested{0.0f};
+    std::atomic<float> lowPassRequested{0.0f};
+    std::atomic<int> filterOrderRequested{2};
+    std::atomic<bool> filterChangeRequested{false};
+    std::atomic<int> outputRateHz{100};
+    std::atomic<bool> multiAxisTapsRequested{false};
+    std::atomic<bool> earlyTapsRequested{false};
+    std::atomic<int> spectralOnsetHopRequested{0};  ///< 0 while spectral onsets are off
+    uint64_t lastContinuousOutputTime = 0;
     
-    // Raw sensor data
-    struct SensorData
-    {
-        float accelX = 0, accelY = 0, accelZ = 0;
-        float gyroX = 0, gyroY = 0, gyroZ = 0;
-        float magX = 0, magY = 0, magZ = 0;
-    } sensorData;
-    
-    void timerCallback() override;
-    void pollGestures();
-    bool getSensorDataFromConnection();
+    // Message thread -> processing thread: calibration requests in order, parameters latest-wins
+    enum class CalibrationCommand : uint8_t { start, stop, reset };
+    SampleRing<CalibrationCommand, 16> calibrationCommands;
+    uint32_t calibrationCommandsIssued = 0;                      ///< Message thread
+    uint32_t calibrationCommandsApplied = 0;                     ///< Processing thread
+    SnapshotExchange<GestureDetector::Parameters> parameterExchange;
+    GestureDetector::Parameters requestedParameters;             ///< Message thread copy of the last published
+    
+    // Processing thread -> message thread
+    mutable SnapshotExchange<CalibrationState> calibrationState;
+    
+    // Classification - the model is handed over from the message thread, the rest is processing-thread state
+    GestureClassifier classifier;
+    std::shared_ptr<const GestureClassifier::Model> pendingModel;  ///< Accessed with std::atomic_load/exchange
+    std::vector<std::shared_ptr<const GestureClassifier::Model>> retiredModels; ///< Setter side, under retiredLock
+    juce::CriticalSection retiredLock;
+    std::atomic<bool> modelChangeRequested{false};
+    std::atomic<int> lastClassIndex{-1};
+    std::atomic<float> lastClassConfidence{0.0f};
+    
+    // Template matching, handed over the same way
+    TemplateMatcher matcher;
+    std::shared_ptr<const TemplateMatcher::Library> pendingLibrary;  ///< Accessed with std::atomic_load/exchange
+    std::vector<std::shared_ptr<const TemplateMatcher::Library>> retiredLibraries; ///< Setter side, under retiredLock
+    std::atomic<bool> libraryChangeRequested{false};
+    std::atomic<int> lastMatchLabel{-1};
+    std::atomic<float> lastMatchDistance{0.0f};
+    
+    PipelineStats stats;
+    juce::uint32 lastStatsOutputMs = 0;
+    uint64_t lastDriftSamplesSent = 0;
+    
+    // Device clock to OSC time tag mapping
+    uint64_t deviceTimeOrigin = 0;
+    uint64_t hostTimeTagOrigin = 0;
+    bool timeOriginSet = false;
+    
+    // Raw sensor data for the newest frame of the block being processed
+    IMUData sensorData;
+    
+    void run() override;
+    juce::String oscAddress(const char* path) const { return oscPrefix + path; }
     bool ensureOSCConnection();
-    void sendDataViaOSC();
+    juce::OSCTimeTag getTimeTag(uint64_t deviceTimestamp);
+    void sendDataViaOSC(uint64_t timestamp, bool includeContinuous,
+                        const GestureDetector::DetectionEvent* frameEvents, size_t numEvents);
+    void sendStatsViaOSC();
+    void sendDriftViaOSC();
+    void sendClassViaOSC(const GestureClassifier::Prediction& prediction);
+    void sendMatchViaOSC(const TemplateMatcher::Match& match);
+    void queueCalibrationCommand(CalibrationCommand command);
+    void applyCalibrationCommand(CalibrationCommand command);
+    void publishCalibrationState();
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GestureManager)
 };
@@ -0,0 +1,225 @@
+/**
+ * @file MadgwickFilter.cpp
+ * @brief Host-side orientation estimate for devices that don't stream their own AHRS output
+ *
+ * The update steps follow Sebastian Madgwick's reference implementation of
+ * "An efficient orientation filter for inertial and inertial/magnetic sensor
+ * arrays" (2010).
+ */
+
+#include "MadgwickFilter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float degreesToRadians = 0.017453292519943295f;
+
+    inline float inverseLength(float a, float b, float c)
+    {
+        return 1.0f / std::sqrt(a * a + b * b + c * c);
+    }
+}
+
+MadgwickFilter::MadgwickFilter(float beta)
+    : gain(beta)
+{
+}
+
+void MadgwickFilter::reset()
+{
+    q0 = 1.0f;
+    q1 = q2 = q3 = 0.0f;
+    lastTimestamp = 0;
+    elapsed = 0.0f;
+}
+
+void MadgwickFilter::process(IMUData& frame)
+{
+    // Device clock step; a missing, repeated or wildly late stamp reuses the last good one
+    float dt = lastStep;
+    if (lastTimestamp != 0 && frame.timestamp > lastTimestamp)
+    {
+        const float step = static_cast<float>(frame.timestamp - lastTimestamp) * 1.0e-6f;
+        if (step <= maxStepSeconds)
+            dt = lastStep = step;
+    }
+    lastTimestamp = frame.timestamp;
+
+    // High gain at start-up pulls the estimate onto gravity (and north) in well under a second
+    const float ramp = std::max(0.0f, 1.0f - elapsed / rampSeconds);
+    const float beta = gain + (initialGain - gain) * ramp;
+    elapsed = std::min(elapsed + dt, rampSeconds);
+
+    const float gx = frame.gyroX * degreesToRadians;
+    const float gy = frame.gyroY * degreesToRadians;
+    const float gz = frame.gyroZ * degreesToRadians;
+
+    if (frame.magX == 0.0f && frame.magY == 0.0f && frame.magZ == 0.0f)
+        updateIMU(gx, gy, gz, frame.accelX, frame.accelY, frame.accelZ, beta, dt);
+    else
+        update(gx, gy, gz, frame.accelX, frame.accelY, frame.accelZ, frame.magX, frame.magY, frame.magZ, beta, dt);
+
+    // Gravity in the sensor frame, removed to leave the acceleration the textile itself sees (g)
+    const float gravityX = 2.0f * (q1 * q3 - q0 * q2);
+    const float gravityY = 2.0f * (q0 * q1 + q2 * q3);
+    const float gravityZ = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+    frame.linearAccelX = frame.accelX - gravityX;
+    frame.linearAccelY = frame.accelY - gravityY;
+    frame.linearAccelZ = frame.accelZ - gravityZ;
+    frame.quatW = q0;
+    frame.quatX = q1;
+    frame.quatY = q2;
+    frame.quatZ = q3;
+    frame.hasFusion = true;
+}
+
+void MadgwickFilter::update(float gx, float gy, float gz, float ax, float ay, float az,
+                            float mx, float my, float mz, float beta, float dt)
+{
+    // Rate of change of quaternion from the gyroscope
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    // Corrective step only with a usable accelerometer reading (avoids NaN in normalisation)
+    if (!(ax == 0.0f && ay == 0.0f && az == 0.0f))
+    {
+        float recipNorm = inverseLength(ax, ay, az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        recipNorm = inverseLength(mx, my, mz);
+        mx *= recipNorm;
+        my *= recipNorm;
+        mz *= recipNorm;
+
+        // Auxiliary variables to avoid repeated arithmetic
+        const float _2q0mx = 2.0f * q0 * mx;
+        const float _2q0my = 2.0f * q0 * my;
+        const float _2q0mz = 2.0f * q0 * mz;
+        const float _2q1mx = 2.0f * q1 * mx;
+        const float _2q0 = 2.0f * q0;
+        const float _2q1 = 2.0f * q1;
+        const float _2q2 = 2.0f * q2;
+        const float _2q3 = 2.0f * q3;
+        const float _2q0q2 = 2.0f * q0 * q2;
+        const float _2q2q3 = 2.0f * q2 * q3;
+        const float q0q0 = q0 * q0;
+        const float q0q1 = q0 * q1;
+        const float q0q2 = q0 * q2;
+        const float q0q3 = q0 * q3;
+        const float q1q1 = q1 * q1;
+        const float q1q2 = q1 * q2;
+        const float q1q3 = q1 * q3;
+        const float q2q2 = q2 * q2;
+        const float q2q3 = q2 * q3;
+        const float q3q3 = q3 * q3;
+
+        // Reference direction of Earth's magnetic field
+        const float hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+        const float hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+        const float _2bx = std::sqrt(hx * hx + hy * hy);
+        const float _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+        const float _4bx = 2.0f * _2bx;
+        const float _4bz = 2.0f * _2bz;
+
+        // Gradient descent corrective step
+        const float fx = _2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+        const float fy = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+        const float fz = _2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz;
+        const float gravityErrorX = 2.0f * q1q3 - _2q0q2 - ax;
+        const float gravityErrorY = 2.0f * q0q1 + _2q2q3 - ay;
+        const float gravityErrorZ = 1.0f - 2.0f * q1q1 - 2.0f * q2q2 - az;
+
+        float s0 = -_2q2 * gravityErrorX + _2q1 * gravityErrorY - _2bz * q2 * fx
+                 + (-_2bx * q3 + _2bz * q1) * fy + _2bx * q2 * fz;
+        float s1 = _2q3 * gravityErrorX + _2q0 * gravityErrorY - 4.0f * q1 * gravityErrorZ + _2bz * q3 * fx
+                 + (_2bx * q2 + _2bz * q0) * fy + (_2bx * q3 - _4bz * q1) * fz;
+        float s2 = -_2q0 * gravityErrorX + _2q3 * gravityErrorY - 4.0f * q2 * gravityErrorZ + (-_4bx * q2 - _2bz * q0) * fx
+                 + (_2bx * q1 + _2bz * q3) * fy + (_2bx * q0 - _4bz * q2) * fz;
+        float s3 = _2q1 * gravityErrorX + _2q2 * gravityErrorY + (-_4bx * q3 + _2bz * q1) * fx
+                 + (-_2bx * q0 + _2bz * q2) * fy + _2bx * q1 * fz;
+
+        const float stepNorm = std::sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+        if (stepNorm > 0.0f)
+        {
+            recipNorm = 1.0f / stepNorm;
+            qDot1 -= beta * s0 * recipNorm;
+            qDot2 -= beta * s1 * recipNorm;
+            qDot3 -= beta * s2 * recipNorm;
+            qDot4 -= beta * s3 * recipNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    const float recipNorm = 1.0f / std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 *= recipNorm;
+    q1 *= recipNorm;
+    q2 *= recipNorm;
+    q3 *= recipNorm;
+}
+
+void MadgwickFilter::updateIMU(float gx, float gy, float gz, float ax, float ay, float az, float beta, float dt)
+{
+    // Rate of change of quaternion from the gyroscope
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (!(ax == 0.0f && ay == 0.0f && az == 0.0f))
+    {
+        const float recipNorm = inverseLength(ax, ay, az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        const float _2q0 = 2.0f * q0;
+        const float _2q1 = 2.0f * q1;
+        const float _2q2 = 2.0f * q2;
+        const float _2q3 = 2.0f * q3;
+        const float _4q0 = 4.0f * q0;
+        const float _4q1 = 4.0f * q1;
+        const float _4q2 = 4.0f * q2;
+        const float _8q1 = 8.0f * q1;
+        const float _8q2 = 8.0f * q2;
+        const float q0q0 = q0 * q0;
+        const float q1q1 = q1 * q1;
+        const float q2q2 = q2 * q2;
+        const float q3q3 = q3 * q3;
+
+        // Gradient descent corrective step, gravity only
+        const float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        const float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        const float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        const float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+        const float stepNorm = std::sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+        if (stepNorm > 0.0f)
+        {
+            qDot1 -= beta * s0 / stepNorm;
+            qDot2 -= beta * s1 / stepNorm;
+            qDot3 -= beta * s2 / stepNorm;
+            qDot4 -= beta * s3 / stepNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    const float recipNorm = 1.0f / std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 *= recipNorm;
+    q1 *= recipNorm;
+    q2 *= recipNorm;
+    q3 *= recipNorm;
+}
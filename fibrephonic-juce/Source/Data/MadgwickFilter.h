@@ -0,0 +1,72 @@
+/**
+ * @file MadgwickFilter.h
+ * @brief Host-side orientation estimate for devices that don't stream their own AHRS output
+ */
+
+#pragma once
+
+#include <cstdint>
+#include "../Helpers.h"
+
+/**
+ * @class MadgwickFilter
+ * @brief Madgwick gradient-descent AHRS over one device's inertial and magnetometer stream
+ *
+ * Gyroscope integration is corrected towards the orientation implied by the
+ * accelerometer (gravity) and, when it reads anything, the magnetometer
+ * (heading), at a rate set by the gain beta. The gain starts high and ramps
+ * down over the first few seconds, so the estimate snaps to the sensor's pose
+ * at start-up rather than slowly converging from identity.
+ *
+ * process() fills in a frame's quaternion and gravity-free acceleration the
+ * same way the x-IMU3's on-board AHRS does, so everything downstream (motion
+ * source selection, OSC output) treats host and device fusion alike. The step
+ * is a few hundred flops with no allocation - cheap enough to run for every
+ * device at the full stream rate - but it does branch on the data: a frame
+ * whose magnetometer reads exactly zero takes the IMU-only update instead of
+ * the MARG one, a zero accelerometer skips the correction, a time step is
+ * only taken from a forward, bounded timestamp gap, and the gradient step is
+ * only normalised when it is non-zero.
+ *
+ * Single-threaded: owned and used by one GestureManager's processing thread.
+ */
+class MadgwickFilter
+{
+public:
+    /** @param beta Steady-state correction gain; higher trusts the accelerometer/magnetometer more */
+    explicit MadgwickFilter(float beta = 0.1f);
+
+    void setGain(float beta) { gain = beta; }
+
+    /** @brief Forget the orientation and restart the start-up gain ramp */
+    void reset();
+
+    /**
+     * @brief Advance the estimate with one frame and write it back
+     *
+     * Sets the frame's quaternion and linear acceleration and marks it as
+     * carrying fusion output. The time step comes from the device timestamps.
+     */
+    void process(IMUData& frame);
+
+    float getW() const { return q0; }
+    float getX() const { return q1; }
+    float getY() const { return q2; }
+    float getZ() const { return q3; }
+
+private:
+    float gain;
+    float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f;
+
+    uint64_t lastTimestamp = 0;
+    float lastStep = 0.01f;          ///< Seconds; reused when a timestamp is missing or out of order
+    float elapsed = 0.0f;            ///< Seconds since reset, for the start-up ramp
+
+    static constexpr float initialGain = 2.5f;
+    static constexpr float rampSeconds = 3.0f;
+    static constexpr float maxStepSeconds = 0.1f;   ///< Longer gaps are treated as one missed sample
+
+    void update(float gx, float gy, float gz, float ax, float ay, float az,
+                float mx, float my, float mz, float beta, float dt);
+    void updateIMU(float gx, float gy, float gz, float ax, float ay, float az, float beta, float dt);
+};
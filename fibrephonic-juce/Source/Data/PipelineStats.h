@@ -0,0 +1,105 @@
+/**
+ * @file PipelineStats.h
+ * @brief Lock-free live metrics for one sensor pipeline
+ */
+
+#pragma once
+
+#include <x-IMU3/Cpp/Ximu3.hpp>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class PipelineStats
+ * @brief Link statistics from the x-IMU3 SDK alongside our own processing counters
+ *
+ * Every field is a relaxed atomic with a single writer: link figures are written
+ * by the SDK's statistics callback (about once a second), processing figures by
+ * whichever thread runs the detector. Any thread may take a snapshot, so the UI
+ * and the OSC /stats stream can watch throughput without touching either path.
+ */
+class PipelineStats
+{
+public:
+    struct Snapshot
+    {
+        // Link, as reported by the device connection
+        uint32_t linkDataRate = 0;      ///< bytes/s
+        uint32_t linkMessageRate = 0;   ///< messages/s
+        uint32_t linkErrorRate = 0;     ///< decode errors/s
+        uint64_t linkErrorTotal = 0;
+
+        // Pipeline
+        uint64_t samplesProcessed = 0;
+        uint64_t samplesDropped = 0;    ///< Frames lost to a full sample ring
+        float meanDetectorMicros = 0.0f;
+        float maxDetectorMicros = 0.0f; ///< Worst per-frame time (averaged over its block) since the last resetPeak()
+    };
+
+    /** @brief Store the figures from an x-IMU3 statistics callback */
+    void recordLink(const ximu3::XIMU3_Statistics& statistics)
+    {
+        linkDataRate.store(statistics.data_rate, std::memory_order_relaxed);
+        linkMessageRate.store(statistics.message_rate, std::memory_order_relaxed);
+        linkErrorRate.store(statistics.error_rate, std::memory_order_relaxed);
+        linkErrorTotal.store(statistics.error_total, std::memory_order_relaxed);
+    }
+
+    /** @brief Account for a block of processed frames - called from the processing thread only */
+    void recordBlock(uint64_t numFrames, uint64_t detectorNanos)
+    {
+        if (numFrames == 0)
+            return;
+
+        samplesProcessed.store(samplesProcessed.load(std::memory_order_relaxed) + numFrames, std::memory_order_relaxed);
+        detectorNanosTotal.store(detectorNanosTotal.load(std::memory_order_relaxed) + detectorNanos, std::memory_order_relaxed);
+
+        const uint64_t perFrameNanos = detectorNanos / numFrames;
+        if (perFrameNanos > detectorNanosPeak.load(std::memory_order_relaxed))
+            detectorNanosPeak.store(perFrameNanos, std::memory_order_relaxed);
+    }
+
+    /** @brief Mirror the producer's overrun count - called from the processing thread only */
+    void setSamplesDropped(uint64_t dropped) { samplesDropped.store(dropped, std::memory_order_relaxed); }
+
+    /** @brief Start a new peak-detector-time window */
+    void resetPeak() { detectorNanosPeak.store(0, std::memory_order_relaxed); }
+
+    /** @brief Clear the pipeline counters (link figures are left to the next callback) */
+    void resetPipeline()
+    {
+        samplesProcessed.store(0, std::memory_order_relaxed);
+        samplesDropped.store(0, std::memory_order_relaxed);
+        detectorNanosTotal.store(0, std::memory_order_relaxed);
+        detectorNanosPeak.store(0, std::memory_order_relaxed);
+    }
+
+    Snapshot getSnapshot() const
+    {
+        Snapshot s;
+        s.linkDataRate = linkDataRate.load(std::memory_order_relaxed);
+        s.linkMessageRate = linkMessageRate.load(std::memory_order_relaxed);
+        s.linkErrorRate = linkErrorRate.load(std::memory_order_relaxed);
+        s.linkErrorTotal = linkErrorTotal.load(std::memory_order_relaxed);
+        s.samplesProcessed = samplesProcessed.load(std::memory_order_relaxed);
+        s.samplesDropped = samplesDropped.load(std::memory_order_relaxed);
+
+        const auto totalNanos = detectorNanosTotal.load(std::memory_order_relaxed);
+        s.meanDetectorMicros = s.samplesProcessed > 0
+                                 ? static_cast<float>(totalNanos / s.samplesProcessed) * 0.001f
+                                 : 0.0f;
+        s.maxDetectorMicros = static_cast<float>(detectorNanosPeak.load(std::memory_order_relaxed)) * 0.001f;
+        return s;
+    }
+
+private:
+    std::atomic<uint32_t> linkDataRate{0};
+    std::atomic<uint32_t> linkMessageRate{0};
+    std::atomic<uint32_t> linkErrorRate{0};
+    std::atomic<uint64_t> linkErrorTotal{0};
+
+    std::atomic<uint64_t> samplesProcessed{0};
+    std::atomic<uint64_t> samplesDropped{0};
+    std::atomic<uint64_t> detectorNanosTotal{0};
+    std::atomic<uint64_t> detectorNanosPeak{0};
+};
@@ -0,0 +1,117 @@
+/**
+ * @file SampleRing.h
+ * @brief Wait-free single-producer/single-consumer ring for sensor frames
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class SampleRing
+ * @brief Fixed-capacity SPSC FIFO between the x-IMU3 callback thread and the detector
+ *
+ * The producer (one SDK callback thread) calls push(), the consumer (one processing
+ * thread) calls pop(). Neither side ever blocks, locks or allocates. When the consumer
+ * falls behind and the ring is full, the newest frame is dropped and counted as an
+ * overrun so every frame that does get in is delivered exactly once, in order.
+ *
+ * @tparam T        Trivially copyable frame type (e.g. IMUData)
+ * @tparam Capacity Number of slots, must be a power of two
+ */
+template <typename T, size_t Capacity>
+class SampleRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SampleRing capacity must be a power of two");
+
+public:
+    /** @brief Producer side - returns false (and counts an overrun) if the ring is full */
+    bool push(const T& item)
+    {
+        const auto write = writeIndex.load(std::memory_order_relaxed);
+
+        if (write - readIndex.load(std::memory_order_acquire) >= Capacity)
+        {
+            overruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        slots[write & mask] = item;
+        writeIndex.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Consumer side - returns false if there is nothing to read */
+    bool pop(T& item)
+    {
+        const auto read = readIndex.load(std::memory_order_relaxed);
+
+        if (read == writeIndex.load(std::memory_order_acquire))
+            return false;
+
+        item = slots[read & mask];
+        readIndex.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side - take up to maxItems frames, oldest first, in one go
+     *
+     * One index load and one store for the whole run, so draining a backlog
+     * costs a copy per frame rather than a synchronisation per frame.
+     * @returns Number of frames copied into items
+     */
+    size_t pop(T* items, size_t maxItems)
+    {
+        const auto read = readIndex.load(std::memory_order_relaxed);
+        const auto available = static_cast<size_t>(writeIndex.load(std::memory_order_acquire) - read);
+        const size_t count = available < maxItems ? available : maxItems;
+
+        for (size_t i = 0; i < count; ++i)
+            items[i] = slots[(read + i) & mask];
+
+        if (count > 0)
+            readIndex.store(read + count, std::memory_order_release);
+
+        return count;
+    }
+
+    /** @brief Consumer side - discard everything currently queued */
+    void clear()
+    {
+        readIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    /** @brief Number of frames waiting to be consumed (approximate from other threads) */
+    size_t getNumReady() const
+    {
+        return static_cast<size_t>(writeIndex.load(std::memory_order_acquire)
+                                   - readIndex.load(std::memory_order_acquire));
+    }
+
+    /** @name Counters
+     *  Monotonic counters, safe to read from any thread
+     *  @{
+     */
+    uint64_t getTotalPushed() const  { return writeIndex.load(std::memory_order_relaxed); }
+    uint64_t getTotalPopped() const  { return readIndex.load(std::memory_order_relaxed); }
+    uint64_t getOverrunCount() const { return overruns.load(std::memory_order_relaxed); }
+    /** @} */
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr uint64_t mask = Capacity - 1;
+
+    // Indices run freely and are masked on access; each lives on its own cache line
+    // so the producer and consumer never false-share.
+    alignas(64) std::atomic<uint64_t> writeIndex{0};
+    alignas(64) std::atomic<uint64_t> readIndex{0};
+    alignas(64) std::atomic<uint64_t> overruns{0};
+
+    std::array<T, Capacity> slots{};
+};
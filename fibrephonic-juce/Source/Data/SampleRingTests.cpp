@@ -0,0 +1,104 @@
+/**
+ * @file SampleRingTests.cpp
+ * @brief Two-thread stress test for SampleRing - run with --run-tests
+ */
+
+#include <JuceHeader.h>
+#include "SampleRing.h"
+#include <thread>
+
+class SampleRingTests : public juce::UnitTest
+{
+public:
+    SampleRingTests() : juce::UnitTest("SampleRing", "Data") {}
+
+    void runTest() override
+    {
+        beginTest("Producer and consumer threads");
+
+        // A small ring and a consumer that keeps switching between single and batch
+        // pops, so the indices wrap constantly and the producer regularly finds it full
+        constexpr uint64_t numFrames = 1000000;
+        SampleRing<Frame, 64> ring;
+        uint64_t accepted = 0;
+
+        std::thread producer([&ring, &accepted]
+        {
+            for (uint64_t sequence = 1; sequence <= numFrames; ++sequence)
+            {
+                if (ring.push({ sequence, checkValue(sequence) }))
+                    ++accepted;
+                else
+                    std::this_thread::yield();  // Still dropped, but gives the consumer a chance to catch up
+            }
+        });
+
+        std::array<Frame, 16> batch;
+        uint64_t received = 0, lastSequence = 0, outOfOrder = 0, torn = 0;
+        bool producerDone = false;
+
+        const auto check = [&](const Frame& frame)
+        {
+            if (frame.sequence <= lastSequence)
+                ++outOfOrder;
+
+            if (frame.check != checkValue(frame.sequence))
+                ++torn;
+
+            lastSequence = frame.sequence;
+            ++received;
+        };
+
+        for (int pass = 0;; ++pass)
+        {
+            // Read the flag before draining, so nothing pushed before it was set can be missed
+            producerDone = ring.getTotalPushed() + ring.getOverrunCount() == numFrames;
+
+            size_t numPopped = 0;
+            Frame frame;
+
+            if (pass % 2 == 0)
+            {
+                numPopped = ring.pop(batch.data(), batch.size());
+                for (size_t i = 0; i < numPopped; ++i)
+                    check(batch[i]);
+            }
+            else if (ring.pop(frame))
+            {
+                numPopped = 1;
+                check(frame);
+            }
+
+            if (numPopped == 0)
+            {
+                if (producerDone)
+                    break;
+
+                std::this_thread::yield();
+            }
+        }
+
+        producer.join();
+
+        expectEquals((int) outOfOrder, 0, "frames out of order or repeated");
+        expectEquals((int) torn, 0, "frames read while being written");
+        expect(received == accepted, "every accepted frame delivered once");
+        expect(accepted + ring.getOverrunCount() == numFrames, "every rejected frame counted as an overrun");
+        expect(ring.getTotalPopped() == received);
+        expectEquals((int) ring.getNumReady(), 0);
+
+        logMessage(juce::String((juce::int64) received) + " frames delivered, "
+                   + juce::String((juce::int64) ring.getOverrunCount()) + " overruns");
+    }
+
+private:
+    struct Frame
+    {
+        uint64_t sequence = 0;
+        uint64_t check = 0;
+    };
+
+    static uint64_t checkValue(uint64_t sequence) { return sequence * 0x9E3779B97F4A7C15ull; }
+};
+
+static SampleRingTests sampleRingTests;
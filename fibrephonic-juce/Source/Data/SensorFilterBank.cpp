@@ -0,0 +1,187 @@
+/**
+ * @file SensorFilterBank.cpp
+ * @brief Cascaded biquad high-pass/low-pass stage run across all nine sensor axes at once
+ */
+
+#include "SensorFilterBank.h"
+#include <cmath>
+
+namespace
+{
+    // Section Q values that cascade to a Butterworth response
+    constexpr float butterworth2[] = { 0.70710678f };
+    constexpr float butterworth4[] = { 0.54119610f, 1.30656296f };
+
+    // Keep the low-pass clear of Nyquist, where the bilinear design falls apart
+    constexpr double maxCutoffFraction = 0.45;
+}
+
+void SensorFilterBank::setSettings(const Settings& newSettings)
+{
+    settings = newSettings;
+    settings.order = newSettings.order >= maxOrder ? maxOrder : 2;
+    designPending = true;
+}
+
+void SensorFilterBank::prepare(double sampleRate)
+{
+    if (sampleRate <= 0.0)
+        return;
+
+    if (designPending
+        || (numSections > 0 && std::abs(sampleRate - designedRate) > designedRate * redesignTolerance))
+    {
+        design(sampleRate);
+    }
+}
+
+void SensorFilterBank::design(double sampleRate)
+{
+    using Coefficients = juce::dsp::IIR::ArrayCoefficients<float>;
+
+    // A new response restarts from the next frame; a rate correction keeps the running state
+    if (designPending)
+        reset();
+
+    designPending = false;
+    designedRate = sampleRate;
+    numSections = 0;
+
+    if (settings.isBypassed())
+        return;
+
+    const float* qs = settings.order == maxOrder ? butterworth4 : butterworth2;
+    const int sectionsPerFilter = settings.order / 2;
+    const float maxCutoff = static_cast<float>(sampleRate * maxCutoffFraction);
+
+    auto addSection = [this] (const std::array<float, 6>& c)
+    {
+        // { b0, b1, b2, a0, a1, a2 }
+        const float a0 = c[3];
+        auto& section = sections[static_cast<size_t>(numSections++)];
+        section.b0 = Vector::expand(c[0] / a0);
+        section.b1 = Vector::expand(c[1] / a0);
+        section.b2 = Vector::expand(c[2] / a0);
+        section.a1 = Vector::expand(c[4] / a0);
+        section.a2 = Vector::expand(c[5] / a0);
+        section.dcGain = Vector::expand((c[0] + c[1] + c[2]) / (c[3] + c[4] + c[5]));
+    };
+
+    if (settings.highPassHz > 0.0f)
+        for (int i = 0; i < sectionsPerFilter; ++i)
+            addSection(Coefficients::makeHighPass(sampleRate, juce::jmin(settings.highPassHz, maxCutoff), qs[i]));
+
+    if (settings.lowPassHz > 0.0f)
+        for (int i = 0; i < sectionsPerFilter; ++i)
+            addSection(Coefficients::makeLowPass(sampleRate, juce::jmin(settings.lowPassHz, maxCutoff), qs[i]));
+}
+
+void SensorFilterBank::reset()
+{
+    primed = false;
+}
+
+void SensorFilterBank::loadFrame(const IMUData& frame)
+{
+    const bool linear = frame.hasFusion;
+    lanes[0] = linear ? frame.linearAccelX : frame.accelX;
+    lanes[1] = linear ? frame.linearAccelY : frame.accelY;
+    lanes[2] = linear ? frame.linearAccelZ : frame.accelZ;
+    lanes[3] = frame.gyroX;
+    lanes[4] = frame.gyroY;
+    lanes[5] = frame.gyroZ;
+    lanes[6] = frame.magX;
+    lanes[7] = frame.magY;
+    lanes[8] = frame.magZ;
+}
+
+void SensorFilterBank::storeFrame(IMUData& frame) const
+{
+    if (frame.hasFusion)
+    {
+        frame.linearAccelX = lanes[0];
+        frame.linearAccelY = lanes[1];
+        frame.linearAccelZ = lanes[2];
+    }
+    else
+    {
+        frame.accelX = lanes[0];
+        frame.accelY = lanes[1];
+        frame.accelZ = lanes[2];
+    }
+
+    frame.gyroX = lanes[3];
+    frame.gyroY = lanes[4];
+    frame.gyroZ = lanes[5];
+    frame.magX = lanes[6];
+    frame.magY = lanes[7];
+    frame.magZ = lanes[8];
+}
+
+// Sets every section's state as if the loaded frame had been the input forever,
+// so switching on (or gravity appearing under a high-pass) doesn't ring like a tap
+void SensorFilterBank::prime()
+{
+    for (size_t v = 0; v < numVectors; ++v)
+    {
+        auto x = Vector::fromRawArray(lanes.data() + v * Vector::SIMDNumElements);
+
+        for (int s = 0; s < numSections; ++s)
+        {
+            const auto& section = sections[static_cast<size_t>(s)];
+            const auto y = section.dcGain * x;
+            state2[static_cast<size_t>(s)][v] = section.b2 * x - section.a2 * y;
+            state1[static_cast<size_t>(s)][v] = y - section.b0 * x;
+            x = y;
+        }
+    }
+
+    primed = true;
+}
+
+void SensorFilterBank::process(IMUData* frames, size_t numFrames)
+{
+    if (numSections == 0)
+        return;
+
+    const juce::ScopedNoDenormals noDenormals;
+
+    for (size_t i = 0; i < numFrames; ++i)
+    {
+        IMUData& frame = frames[i];
+
+        // The accel lanes change meaning with the motion source, so they start over with it
+        if (frame.hasFusion != lastHadFusion)
+        {
+            lastHadFusion = frame.hasFusion;
+            primed = false;
+        }
+
+        loadFrame(frame);
+
+        if (!primed)
+            prime();
+
+        for (size_t v = 0; v < numVectors; ++v)
+        {
+            float* lane = lanes.data() + v * Vector::SIMDNumElements;
+            auto x = Vector::fromRawArray(lane);
+
+            for (int s = 0; s < numSections; ++s)
+            {
+                const auto& section = sections[static_cast<size_t>(s)];
+                auto& s1 = state1[static_cast<size_t>(s)][v];
+                auto& s2 = state2[static_cast<size_t>(s)][v];
+
+                const auto y = section.b0 * x + s1;
+                s1 = section.b1 * x - section.a1 * y + s2;
+                s2 = section.b2 * x - section.a2 * y;
+                x = y;
+            }
+
+            x.copyToRawArray(lane);
+        }
+
+        storeFrame(frame);
+    }
+}
@@ -0,0 +1,98 @@
+/**
+ * @file SensorFilterBank.h
+ * @brief Cascaded biquad high-pass/low-pass stage run across all nine sensor axes at once
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include "../Helpers.h"
+
+/**
+ * @class SensorFilterBank
+ * @brief Butterworth high-pass and low-pass sections applied to each frame before detection
+ *
+ * The high-pass removes DC - gravity, gyro bias, the local field - and slow
+ * drift; the low-pass removes sensor noise above the band gestures live in.
+ * Each is a cascade of second-order sections (transposed direct form II), one
+ * section for 2nd order or two with Butterworth Q values for 4th order.
+ *
+ * Every axis shares the same coefficients, so the nine values of a frame
+ * (motion acceleration, gyroscope, magnetometer) are packed into SIMD
+ * registers and each section updates all of them in a handful of vector
+ * multiply-adds. The motion acceleration is the gravity-free linear
+ * acceleration when the frame carries AHRS output, matching what
+ * GestureDetector detects on.
+ *
+ * Coefficients are designed for the measured stream rate and redesigned only
+ * when it drifts by more than a couple of percent; designing and filtering
+ * never allocate. Single-threaded: owned and used by one GestureManager's
+ * processing thread.
+ */
+class SensorFilterBank
+{
+public:
+    static constexpr int numAxes = 9;          ///< Motion accel X/Y/Z, gyro X/Y/Z, mag X/Y/Z
+    static constexpr int maxOrder = 4;
+
+    struct Settings
+    {
+        float highPassHz = 0.0f;   ///< 0 = no high-pass
+        float lowPassHz = 0.0f;    ///< 0 = no low-pass
+        int order = 2;             ///< 2 or 4, for both filters
+
+        bool isBypassed() const { return highPassHz <= 0.0f && lowPassHz <= 0.0f; }
+    };
+
+    SensorFilterBank() = default;
+
+    /** @brief Change the response; the filter state restarts at the next frame */
+    void setSettings(const Settings& newSettings);
+    const Settings& getSettings() const { return settings; }
+
+    bool isActive() const { return numSections > 0; }
+
+    /**
+     * @brief Follow the stream rate, redesigning the sections if it has moved far enough to matter
+     * @param sampleRate Measured rate in Hz
+     */
+    void prepare(double sampleRate);
+
+    /** @brief Restart the filter state; the next frame is taken as the steady input so nothing rings */
+    void reset();
+
+    /** @brief Filter a run of frames in place */
+    void process(IMUData* frames, size_t numFrames);
+
+private:
+    using Vector = juce::dsp::SIMDRegister<float>;
+
+    static constexpr size_t numVectors = (numAxes + Vector::SIMDNumElements - 1) / Vector::SIMDNumElements;
+    static constexpr int maxSections = maxOrder;   ///< maxOrder / 2 each for the high- and low-pass
+    static constexpr double redesignTolerance = 0.02;
+
+    /** Coefficients normalised by a0, each broadcast across a register */
+    struct Section
+    {
+        Vector b0, b1, b2, a1, a2;
+        Vector dcGain;             ///< Response at 0 Hz, for starting the state at rest
+    };
+
+    Settings settings;
+    bool designPending = false;
+    double designedRate = 0.0;
+    int numSections = 0;
+    bool primed = false;             ///< False until the state has been set from a first frame
+    bool lastHadFusion = false;
+
+    std::array<Section, maxSections> sections;
+    std::array<std::array<Vector, numVectors>, maxSections> state1, state2;
+
+    alignas(Vector::SIMDRegisterSize) std::array<float, numVectors * Vector::SIMDNumElements> lanes{};
+
+    void design(double sampleRate);
+    void loadFrame(const IMUData& frame);
+    void storeFrame(IMUData& frame) const;
+    void prime();
+};
@@ -0,0 +1,120 @@
+/**
+ * @file SensorHistory.h
+ * @brief Fixed-capacity structure-of-arrays history of IMU frames
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "../Helpers.h"
+
+/**
+ * @class SensorHistory
+ * @brief Ring of recent frames stored as one contiguous float lane per axis
+ *
+ * Each lane is 64-byte aligned and mirrored: every value is written twice,
+ * Capacity slots apart, so the most recent N samples of any axis are always
+ * one contiguous run (oldest first). Window statistics are plain loops over
+ * a float pointer, which the compiler vectorises, and storage is allocated
+ * once with the owner - pushing a frame never touches the allocator.
+ *
+ * Single-threaded: owned and used by one GestureDetector.
+ */
+template <size_t Capacity>
+class SensorHistory
+{
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SensorHistory capacity must be a power of two");
+
+    enum Axis
+    {
+        AccelX, AccelY, AccelZ,
+        GyroX, GyroY, GyroZ,
+        MagX, MagY, MagZ,
+        NumAxes
+    };
+
+    /** @brief Append a frame, discarding the oldest once the history is full */
+    void push(const IMUData& sample)
+    {
+        const size_t slot = head & (Capacity - 1);
+
+        write(AccelX, slot, sample.accelX);
+        write(AccelY, slot, sample.accelY);
+        write(AccelZ, slot, sample.accelZ);
+        write(GyroX, slot, sample.gyroX);
+        write(GyroY, slot, sample.gyroY);
+        write(GyroZ, slot, sample.gyroZ);
+        write(MagX, slot, sample.magX);
+        write(MagY, slot, sample.magY);
+        write(MagZ, slot, sample.magZ);
+
+        timestamps[slot] = sample.timestamp;
+        timestamps[slot + Capacity] = sample.timestamp;
+
+        ++head;
+        count = std::min(count + 1, length);
+    }
+
+    /** @brief Limit how many samples are kept visible (clamped to 1..Capacity) */
+    void setLength(size_t samples)
+    {
+        length = std::clamp<size_t>(samples, 1, Capacity);
+        count = std::min(count, length);
+    }
+
+    void clear() { count = 0; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+
+    /**
+     * @brief The most recent n values of one axis as a contiguous array, oldest first
+     * @param n Number of samples; must not exceed size()
+     */
+    const float* window(Axis axis, size_t n) const
+    {
+        return lanes[axis] + start(n);
+    }
+
+    /** @brief Timestamps matching window(axis, n) */
+    const uint64_t* timestampWindow(size_t n) const
+    {
+        return timestamps + start(n);
+    }
+
+    /** @brief Newest value of one axis - only valid when not empty */
+    float latest(Axis axis) const { return lanes[axis][start(1)]; }
+    uint64_t latestTimestamp() const { return timestamps[start(1)]; }
+
+    /** @brief Reassemble a frame; index 0 is the oldest visible sample */
+    IMUData getSample(size_t index) const
+    {
+        const size_t i = start(count) + index;
+        return IMUData(lanes[AccelX][i], lanes[AccelY][i], lanes[AccelZ][i],
+                       lanes[GyroX][i], lanes[GyroY][i], lanes[GyroZ][i],
+                       lanes[MagX][i], lanes[MagY][i], lanes[MagZ][i],
+                       timestamps[i]);
+    }
+
+private:
+    void write(Axis axis, size_t slot, float value)
+    {
+        lanes[axis][slot] = value;
+        lanes[axis][slot + Capacity] = value;
+    }
+
+    /** Slot of the first of the last n samples; below Capacity, so the mirror holds all n after it */
+    size_t start(size_t n) const { return (head - n) & (Capacity - 1); }
+
+    alignas(64) float lanes[NumAxes][2 * Capacity] = {};
+    alignas(64) uint64_t timestamps[2 * Capacity] = {};
+
+    size_t head = 0;          ///< Total samples pushed; next slot is head & (Capacity - 1)
+    size_t count = 0;         ///< Visible samples
+    size_t length = Capacity; ///< Visible history limit
+};
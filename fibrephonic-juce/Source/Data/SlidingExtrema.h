@@ -0,0 +1,104 @@
+/**
+ * @file SlidingExtrema.h
+ * @brief Amortised O(1) running max and min over a sliding window
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class SlidingExtrema
+ * @brief Monotonic-queue max/min of the last N values of one channel
+ *
+ * Each queue keeps only the values that could still become the extreme of
+ * the window (a decreasing run for the max, an increasing run for the min),
+ * tagged with their sample index. A push discards the entries it dominates
+ * and any that have fallen out of the window, so every value is added and
+ * removed at most once and getMax()/getMin() just read the front.
+ *
+ * Storage is a fixed ring of Capacity entries per queue; the window length
+ * can change at run time (e.g. with the stream rate) up to Capacity.
+ */
+template <size_t Capacity>
+class SlidingExtrema
+{
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SlidingExtrema capacity must be a power of two");
+
+    /** @brief Set the window length in samples (clamped to 1..Capacity) */
+    void setWindow(size_t samples)
+    {
+        window = std::clamp<size_t>(samples, 1, Capacity);
+        maxQueue.expire(index, window);
+        minQueue.expire(index, window);
+    }
+
+    void push(float value)
+    {
+        ++index;
+        maxQueue.push(index, value, window, [](float kept, float incoming) { return kept <= incoming; });
+        minQueue.push(index, value, window, [](float kept, float incoming) { return kept >= incoming; });
+    }
+
+    /** @brief Forget every value, e.g. to start a new window after an event */
+    void reset()
+    {
+        maxQueue.clear();
+        minQueue.clear();
+    }
+
+    bool empty() const { return maxQueue.count == 0; }
+
+    /** @brief Largest value in the window - only valid when not empty */
+    float getMax() const { return maxQueue.front(); }
+
+    /** @brief Smallest value in the window - only valid when not empty */
+    float getMin() const { return minQueue.front(); }
+
+private:
+    struct Queue
+    {
+        float values[Capacity];
+        uint64_t indices[Capacity];
+        size_t head = 0;
+        size_t count = 0;
+
+        float front() const { return values[head]; }
+
+        void clear() { head = count = 0; }
+
+        /** Drop entries older than the window ending at newestIndex */
+        void expire(uint64_t newestIndex, size_t window)
+        {
+            while (count > 0 && indices[head] + window <= newestIndex)
+            {
+                head = (head + 1) & (Capacity - 1);
+                --count;
+            }
+        }
+
+        template <typename Dominated>
+        void push(uint64_t newIndex, float value, size_t window, Dominated isDominated)
+        {
+            // Expiring first leaves at most window - 1 entries, so the ring never overflows
+            expire(newIndex, window);
+
+            // Entries the new value beats can never be the extreme again
+            while (count > 0 && isDominated(values[(head + count - 1) & (Capacity - 1)], value))
+                --count;
+
+            const size_t slot = (head + count) & (Capacity - 1);
+            values[slot] = value;
+            indices[slot] = newIndex;
+            ++count;
+        }
+    };
+
+    Queue maxQueue, minQueue;
+    size_t window = Capacity;
+    uint64_t index = 0;   ///< Sample index of the most recent push
+};
@@ -0,0 +1,74 @@
+/**
+ * @file SnapshotExchange.h
+ * @brief Wait-free single-writer/single-reader hand-over of the latest copy of a settings or state struct
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class SnapshotExchange
+ * @brief Publishes immutable snapshots from one thread to another without locks or allocation
+ *
+ * A triple buffer: the writer owns one slot, the reader owns another, and the
+ * third is the most recently published snapshot. publish() copies into the
+ * writer's slot and swaps it with the published one in a single atomic
+ * exchange; update() swaps the published slot for the reader's when there is
+ * something new. Neither side ever waits for the other, and the reader's
+ * snapshot never changes underneath it - intermediate snapshots are simply
+ * skipped, which is what settings and status want.
+ *
+ * Used in both directions between the message thread and a processing thread:
+ * parameters published by the GUI and picked up between blocks, and detector
+ * state published after each block for the GUI to display.
+ *
+ * @tparam T Copy-assignable snapshot type; copied whole on every publish
+ */
+template <typename T>
+class SnapshotExchange
+{
+public:
+    /** @brief Writer side - make value the latest snapshot */
+    void publish(const T& value)
+    {
+        slots[writeSlot] = value;
+        const auto previous = published.exchange(static_cast<uint8_t>(writeSlot | freshBit), std::memory_order_acq_rel);
+        writeSlot = previous & slotMask;
+    }
+
+    /** @brief Reader side - take the newest snapshot if one arrived since the last call
+     *  @returns true if get() now returns a different snapshot */
+    bool update()
+    {
+        if ((published.load(std::memory_order_relaxed) & freshBit) == 0)
+            return false;
+
+        const auto previous = published.exchange(readSlot, std::memory_order_acq_rel);
+        readSlot = previous & slotMask;
+        return true;
+    }
+
+    /** @brief Reader side - the snapshot taken by the last update() (default-constructed before the first) */
+    const T& get() const { return slots[readSlot]; }
+
+    /** @brief Reader side - update(), then the newest snapshot */
+    const T& latest()
+    {
+        update();
+        return get();
+    }
+
+private:
+    static constexpr uint8_t slotMask = 0x3;
+    static constexpr uint8_t freshBit = 0x4;   ///< Set by publish(), cleared when the reader takes the slot
+
+    std::array<T, 3> slots{};
+
+    // Each side's own slot index is only touched by that side
+    alignas(64) std::atomic<uint8_t> published{1};
+    alignas(64) uint8_t writeSlot = 0;
+    alignas(64) uint8_t readSlot = 2;
+};
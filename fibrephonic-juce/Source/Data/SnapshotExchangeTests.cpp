@@ -0,0 +1,109 @@
+/**
+ * @file SnapshotExchangeTests.cpp
+ * @brief Two-thread stress test for SnapshotExchange - run with --run-tests
+ */
+
+#include <JuceHeader.h>
+#include "SnapshotExchange.h"
+#include <thread>
+
+class SnapshotExchangeTests : public juce::UnitTest
+{
+public:
+    SnapshotExchangeTests() : juce::UnitTest("SnapshotExchange", "Data") {}
+
+    void runTest() override
+    {
+        beginTest("Writer and reader threads");
+
+        // Snapshots wider than a cache line, so a torn copy would show up as a mismatch
+        constexpr uint64_t numSnapshots = 1000000;
+        SnapshotExchange<Snapshot> exchange;
+        std::atomic<bool> writerDone{false};
+
+        std::thread writer([&exchange, &writerDone]
+        {
+            for (uint64_t sequence = 1; sequence <= numSnapshots; ++sequence)
+                exchange.publish(makeSnapshot(sequence));
+
+            writerDone.store(true);
+        });
+
+        uint64_t lastSequence = 0, numTaken = 0, backwards = 0, torn = 0, changedUnderneath = 0;
+
+        for (;;)
+        {
+            // Read the flag first: once it is set, one more update() must see the final snapshot
+            const bool finished = writerDone.load();
+
+            if (exchange.update())
+            {
+                const auto& snapshot = exchange.get();
+                const auto sequence = snapshot.sequence;
+
+                if (sequence <= lastSequence)
+                    ++backwards;
+
+                if (!isConsistent(snapshot))
+                    ++torn;
+
+                // The reader's slot is its own until the next update(), whatever the writer does
+                std::this_thread::yield();
+
+                if (snapshot.sequence != sequence || !isConsistent(snapshot))
+                    ++changedUnderneath;
+
+                lastSequence = sequence;
+                ++numTaken;
+            }
+            else if (finished)
+            {
+                break;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        writer.join();
+
+        expectEquals((int) backwards, 0, "snapshots taken out of order or twice");
+        expectEquals((int) torn, 0, "snapshots read while being written");
+        expectEquals((int) changedUnderneath, 0, "reader's snapshot modified by the writer");
+        expect(lastSequence == numSnapshots, "the final snapshot reaches the reader");
+        expect(!exchange.update(), "nothing fresh once the final snapshot has been taken");
+
+        logMessage(juce::String((juce::int64) numTaken) + " of "
+                   + juce::String((juce::int64) numSnapshots) + " snapshots seen by the reader");
+    }
+
+private:
+    struct Snapshot
+    {
+        uint64_t sequence = 0;
+        std::array<uint64_t, 15> values{};
+    };
+
+    static Snapshot makeSnapshot(uint64_t sequence)
+    {
+        Snapshot snapshot;
+        snapshot.sequence = sequence;
+
+        for (size_t i = 0; i < snapshot.values.size(); ++i)
+            snapshot.values[i] = sequence * (i + 1);
+
+        return snapshot;
+    }
+
+    static bool isConsistent(const Snapshot& snapshot)
+    {
+        for (size_t i = 0; i < snapshot.values.size(); ++i)
+            if (snapshot.values[i] != snapshot.sequence * (i + 1))
+                return false;
+
+        return true;
+    }
+};
+
+static SnapshotExchangeTests snapshotExchangeTests;
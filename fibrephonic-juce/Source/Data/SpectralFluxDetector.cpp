@@ -0,0 +1,200 @@
+/**
+ * @file SpectralFluxDetector.cpp
+ * @brief Onset detection from the spectral flux of a short sliding FFT
+ */
+
+#include "SpectralFluxDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace
+{
+    // One real-to-complex plan per transform size for the life of the process.
+    // Plans are made once, on scratch buffers, and then run on each instance's
+    // own buffers through the new-array execute interface. preparePlan() measures;
+    // an unprepared size gets an estimated plan, which is quick to make.
+    std::mutex planMutex;
+    std::map<int, fftw_plan> planCache;
+
+    int roundToTransformSize(int size)
+    {
+        size = std::clamp(size, 8, 1024);
+
+        // Round down to a power of two
+        while ((size & (size - 1)) != 0)
+            size &= size - 1;
+
+        return size;
+    }
+
+    fftw_plan getSharedPlan(int size, unsigned int planningFlags)
+    {
+        const std::lock_guard<std::mutex> lock(planMutex);
+
+        auto cached = planCache.find(size);
+        if (cached != planCache.end())
+            return cached->second;
+
+        double* scratchIn = static_cast<double*>(fftw_malloc(sizeof(double) * static_cast<size_t>(size)));
+        fftw_complex* scratchOut = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * static_cast<size_t>(size / 2 + 1)));
+
+        fftw_plan plan = fftw_plan_dft_r2c_1d(size, scratchIn, scratchOut, planningFlags);
+
+        fftw_free(scratchIn);
+        fftw_free(scratchOut);
+
+        planCache.emplace(size, plan);
+        return plan;
+    }
+}
+
+void SpectralFluxDetector::preparePlan(int size)
+{
+    getSharedPlan(roundToTransformSize(size), FFTW_MEASURE);
+}
+
+SpectralFluxDetector::SpectralFluxDetector(int size)
+    : fftSize(roundToTransformSize(size))
+{
+    numBins = fftSize / 2 + 1;
+
+    samples.assign(static_cast<size_t>(2 * fftSize), 0.0f);
+    previousMagnitude.assign(static_cast<size_t>(numBins), 0.0f);
+
+    constexpr double twoPi = 6.283185307179586;
+    window.resize(static_cast<size_t>(fftSize));
+    for (int i = 0; i < fftSize; ++i)
+        window[static_cast<size_t>(i)] = 0.5 - 0.5 * std::cos(twoPi * i / fftSize);
+
+    frame = static_cast<double*>(fftw_malloc(sizeof(double) * static_cast<size_t>(fftSize)));
+    spectrum = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * static_cast<size_t>(numBins)));
+    plan = getSharedPlan(fftSize, FFTW_ESTIMATE);
+
+    updateAdaptationAlpha();
+}
+
+SpectralFluxDetector::~SpectralFluxDetector()
+{
+    fftw_free(frame);
+    fftw_free(spectrum);
+}
+
+void SpectralFluxDetector::setHopSize(int samplesPerHop)
+{
+    hopSize = std::clamp(samplesPerHop, 1, fftSize);
+    hopCounter = std::min(hopCounter, hopSize - 1);
+    updateAdaptationAlpha();
+}
+
+void SpectralFluxDetector::setAdaptationLength(float samplesToAdaptOver)
+{
+    adaptationLength = std::max(1.0f, samplesToAdaptOver);
+    updateAdaptationAlpha();
+}
+
+void SpectralFluxDetector::updateAdaptationAlpha()
+{
+    adaptationAlpha = std::min(1.0f, static_cast<float>(hopSize) / adaptationLength);
+}
+
+void SpectralFluxDetector::reset()
+{
+    std::fill(samples.begin(), samples.end(), 0.0f);
+    std::fill(previousMagnitude.begin(), previousMagnitude.end(), 0.0f);
+    head = count = 0;
+    hopCounter = 0;
+    fluxMean = fluxDeviation = lastFlux = 0.0f;
+    armed = true;
+    hasPreviousSpectrum = false;
+    warmup = 0.0f;
+}
+
+float SpectralFluxDetector::process(float value)
+{
+    const size_t size = static_cast<size_t>(fftSize);
+    const size_t slot = head & (size - 1);
+    samples[slot] = value;
+    samples[slot + size] = value;
+    ++head;
+    count = std::min(count + 1, size);
+
+    if (count < size || ++hopCounter < hopSize)
+        return 0.0f;
+
+    hopCounter = 0;
+
+    const float flux = computeFlux();
+    lastFlux = flux;
+
+    if (!hasPreviousSpectrum)
+    {
+        hasPreviousSpectrum = true;
+        return 0.0f;
+    }
+    
+    // Let the statistics settle on the signal before trusting the threshold
+    if (warmup < 1.0f)
+    {
+        warmup += adaptationAlpha;
+        fluxMean += adaptationAlpha * (flux - fluxMean);
+        fluxDeviation += adaptationAlpha * (std::abs(flux - fluxMean) - fluxDeviation);
+        return 0.0f;
+    }
+
+    // Peak picking against the running flux level. Statistics only follow the
+    // quiet stretches, so an onset doesn't raise its own threshold, and the
+    // detector re-arms once the flux is back within one deviation of normal.
+    const float threshold = fluxMean + sensitivity * fluxDeviation + minimumFlux;
+    float onset = 0.0f;
+
+    if (armed)
+    {
+        if (flux > threshold)
+        {
+            armed = false;
+            onset = flux;
+        }
+        else
+        {
+            fluxMean += adaptationAlpha * (flux - fluxMean);
+            fluxDeviation += adaptationAlpha * (std::abs(flux - fluxMean) - fluxDeviation);
+        }
+    }
+    else if (flux < fluxMean + fluxDeviation)
+    {
+        armed = true;
+    }
+
+    return onset;
+}
+
+float SpectralFluxDetector::computeFlux()
+{
+    // The newest fftSize values, oldest first, with the mean removed so gravity
+    // and slow tilt don't leak out of the DC bin through the window
+    const float* recent = samples.data() + (head & static_cast<size_t>(fftSize - 1));
+
+    float mean = 0.0f;
+    for (int i = 0; i < fftSize; ++i)
+        mean += recent[i];
+    mean /= static_cast<float>(fftSize);
+
+    for (int i = 0; i < fftSize; ++i)
+        frame[i] = window[static_cast<size_t>(i)] * static_cast<double>(recent[i] - mean);
+
+    fftw_execute_dft_r2c(plan, frame, spectrum);
+
+    // Half-wave rectified: only energy appearing in a bin counts, not energy leaving it
+    float flux = 0.0f;
+    for (int k = 1; k < numBins; ++k)
+    {
+        const float magnitude = static_cast<float>(std::sqrt(spectrum[k][0] * spectrum[k][0]
+                                                             + spectrum[k][1] * spectrum[k][1]));
+        flux += std::max(0.0f, magnitude - previousMagnitude[static_cast<size_t>(k)]);
+        previousMagnitude[static_cast<size_t>(k)] = magnitude;
+    }
+
+    return flux / static_cast<float>(fftSize);
+}
@@ -0,0 +1,103 @@
+/**
+ * @file SpectralFluxDetector.h
+ * @brief Onset detection from the spectral flux of a short sliding FFT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "fftw3.h"
+
+/**
+ * @class SpectralFluxDetector
+ * @brief Finds onsets as sudden rises in spectral energy rather than level
+ *
+ * Every hop, the last fftSize values are Hann-windowed and transformed. The
+ * half-wave rectified difference from the previous magnitude spectrum (the
+ * spectral flux) is compared with an adaptive threshold. A grazing touch that
+ * never lifts gyro Z past the tap threshold still broadens the spectrum
+ * sharply, so it shows up here.
+ *
+ * Plans are made once per transform size and shared by every instance (FFTW's
+ * planner is not thread safe, but executing a plan is). Measuring a plan takes
+ * milliseconds, so it is done ahead of time by preparePlan() on a non-real-time
+ * thread; construction then only picks the plan up. Each instance has its own
+ * aligned buffers and allocates nothing after construction, so a hop of one
+ * sample is affordable at full stream rate.
+ *
+ * Single-threaded: owned and used by one GestureDetector.
+ */
+class SpectralFluxDetector
+{
+public:
+    /** @param fftSize Transform length in samples, a power of two from 8 to 1024 */
+    explicit SpectralFluxDetector(int fftSize = 32);
+    ~SpectralFluxDetector();
+
+    /**
+     * @brief Measure and cache the plan for a transform size - call off the real-time thread
+     *
+     * An instance created for a size that was never prepared falls back to a
+     * cheaper estimated plan rather than measuring on the caller's thread.
+     */
+    static void preparePlan(int fftSize);
+
+    /** @brief Samples between transforms, clamped to 1..fftSize */
+    void setHopSize(int samples);
+    int getHopSize() const { return hopSize; }
+    int getFFTSize() const { return fftSize; }
+
+    /** @brief How many flux deviations above its running mean count as an onset */
+    void setSensitivity(float deviations) { sensitivity = deviations; }
+
+    /** @brief Length of the running flux statistics, in samples (e.g. one second's worth) */
+    void setAdaptationLength(float samples);
+
+    /** @brief Forget the signal and the flux statistics */
+    void reset();
+
+    /**
+     * @brief Add one sample (e.g. acceleration magnitude)
+     * @returns The flux of an onset that starts on this sample, 0 otherwise
+     */
+    float process(float value);
+
+    /** @brief Flux of the most recent transform, for monitoring */
+    float getLastFlux() const { return lastFlux; }
+
+private:
+    int fftSize;
+    int numBins;
+    int hopSize = 1;
+    int hopCounter = 0;
+
+    // Mirrored input ring, as in SensorHistory: the last fftSize values are contiguous
+    std::vector<float> samples;
+    size_t head = 0;
+    size_t count = 0;
+
+    std::vector<double> window;
+    std::vector<float> previousMagnitude;
+    double* frame = nullptr;             ///< fftw_malloc'd, aligned for SIMD execution
+    fftw_complex* spectrum = nullptr;
+    fftw_plan plan = nullptr;            ///< Shared, owned by the plan cache
+
+    // Onset picking
+    float sensitivity = 4.0f;
+    float adaptationAlpha = 0.01f;       ///< Per transform
+    float adaptationLength = 100.0f;     ///< Samples, converted to transforms with the hop
+    float fluxMean = 0.0f;
+    float fluxDeviation = 0.0f;
+    float lastFlux = 0.0f;
+    bool armed = true;
+    bool hasPreviousSpectrum = false;
+    float warmup = 0.0f;                 ///< Fraction of an adaptation length seen; no onsets until it reaches 1
+    static constexpr float minimumFlux = 1.0e-3f;  // Onsets need at least this much absolute flux
+
+    float computeFlux();
+    void updateAdaptationAlpha();
+
+    SpectralFluxDetector(const SpectralFluxDetector&) = delete;
+    SpectralFluxDetector& operator=(const SpectralFluxDetector&) = delete;
+};
@@ -0,0 +1,358 @@
+/**
+ * @file GestureClassifier.cpp
+ * @brief Runtime k-nearest-neighbour classifier for models recorded with GestureRecorder
+ */
+
+#include "GestureClassifier.h"
+#include "GestureRecorder.h"
+#include <cmath>
+#include <limits>
+
+std::shared_ptr<const GestureClassifier::Model> GestureClassifier::loadModel(const juce::File& csvFile, int k)
+{
+    if (!csvFile.existsAsFile())
+    {
+        DBG("Classifier model not found: " << csvFile.getFullPathName());
+        return nullptr;
+    }
+
+    juce::StringArray lines;
+    csvFile.readLines(lines);
+    lines.removeEmptyStrings();
+
+    if (lines.size() < 2)
+    {
+        DBG("Classifier model has no examples: " << csvFile.getFullPathName());
+        return nullptr;
+    }
+
+    const auto featureNames = CSVLogger::getFeatureNames();
+    const auto header = juce::StringArray::fromTokens(lines[0], ",", "\"");
+
+    // Where each file column goes in the feature vector (-1 for timestamps and unknown columns)
+    std::vector<int> columnFeature(static_cast<size_t>(header.size()), -1);
+    int labelColumn = -1;
+    int featuresFound = 0;
+
+    for (int column = 0; column < header.size(); ++column)
+    {
+        const auto name = header[column].trim();
+        if (name == "label")
+        {
+            labelColumn = column;
+            continue;
+        }
+
+        for (size_t feature = 0; feature < featureNames.size(); ++feature)
+        {
+            if (name == juce::String(featureNames[feature]))
+            {
+                columnFeature[static_cast<size_t>(column)] = static_cast<int>(feature);
+                ++featuresFound;
+                break;
+            }
+        }
+    }
+
+    if (labelColumn < 0 || featuresFound == 0)
+    {
+        DBG("Classifier model has no label or feature columns: " << csvFile.getFullPathName());
+        return nullptr;
+    }
+
+    auto model = std::make_shared<Model>();
+    model->numFeatures = featureNames.size();
+    model->k = juce::jlimit(1, maxK, k);
+
+    const size_t numFeatures = model->numFeatures;
+    std::vector<bool> present(numFeatures, false);
+    for (int feature : columnFeature)
+        if (feature >= 0)
+            present[static_cast<size_t>(feature)] = true;
+
+    for (int line = 1; line < lines.size(); ++line)
+    {
+        const auto tokens = juce::StringArray::fromTokens(lines[line], ",", "\"");
+        if (tokens.size() != header.size())
+            continue;
+
+        const auto label = tokens[labelColumn].trim();
+        if (label.isEmpty())
+            continue;
+
+        int labelIndex = model->labels.indexOf(label);
+        if (labelIndex < 0)
+        {
+            if (model->labels.size() >= maxLabels)
+            {
+                DBG("Classifier model: more than " << maxLabels << " labels, skipping " << label);
+                continue;
+            }
+
+            model->labels.add(label);
+            labelIndex = model->labels.size() - 1;
+        }
+
+        const size_t rowStart = model->examples.size();
+        model->examples.resize(rowStart + numFeatures, 0.0f);
+        for (int column = 0; column < tokens.size(); ++column)
+        {
+            const int feature = columnFeature[static_cast<size_t>(column)];
+            if (feature >= 0)
+                model->examples[rowStart + static_cast<size_t>(feature)] = tokens[column].getFloatValue();
+        }
+
+        model->exampleLabels.push_back(labelIndex);
+    }
+
+    const size_t numExamples = model->numExamples();
+    if (numExamples == 0)
+    {
+        DBG("Classifier model has no labelled rows: " << csvFile.getFullPathName());
+        return nullptr;
+    }
+
+    // z-score every feature so energies (sums of squares) don't swamp means and variances
+    model->mean.assign(numFeatures, 0.0f);
+    model->scale.assign(numFeatures, 0.0f);
+
+    for (size_t feature = 0; feature < numFeatures; ++feature)
+    {
+        if (!present[feature])
+            continue;
+
+        double sum = 0.0;
+        for (size_t row = 0; row < numExamples; ++row)
+            sum += model->examples[row * numFeatures + feature];
+
+        const double mean = sum / static_cast<double>(numExamples);
+
+        double squares = 0.0;
+        for (size_t row = 0; row < numExamples; ++row)
+        {
+            const double deviation = model->examples[row * numFeatures + feature] - mean;
+            squares += deviation * deviation;
+        }
+
+        const double std = std::sqrt(squares / static_cast<double>(numExamples));
+        model->mean[feature] = static_cast<float>(mean);
+        model->scale[feature] = std > 1.0e-9 ? static_cast<float>(1.0 / std) : 0.0f;
+    }
+
+    for (size_t row = 0; row < numExamples; ++row)
+    {
+        float* example = model->examples.data() + row * numFeatures;
+        for (size_t feature = 0; feature < numFeatures; ++feature)
+            example[feature] = (example[feature] - model->mean[feature]) * model->scale[feature];
+    }
+
+    DBG("Classifier model: " << (int) numExamples << " examples, " << model->labels.size() << " classes, "
+        << featuresFound << "/" << (int) numFeatures << " features from " << csvFile.getFileName());
+
+    return model;
+}
+
+GestureClassifier::GestureClassifier()
+    : windowSamples(CSVLogger::featureWindowSamples)
+{
+    ring.assign(static_cast<size_t>(numAxes) * windowSamples, 0.0f);
+    features.assign(CSVLogger::getFeatureNames().size(), 0.0f);
+    query.assign(features.size(), 0.0f);
+}
+
+void GestureClassifier::setModel(std::shared_ptr<const Model> newModel)
+{
+    // A model from another build of the feature set can't be compared with this window
+    if (newModel && newModel->numFeatures != features.size())
+    {
+        DBG("Classifier model has " << (int) newModel->numFeatures << " features, expected " << (int) features.size());
+        newModel = nullptr;
+    }
+
+    model = std::move(newModel);
+    prediction = {};
+    sinceClassified = 0;
+}
+
+void GestureClassifier::reset()
+{
+    std::fill(ring.begin(), ring.end(), 0.0f);
+    sum.fill(0.0);
+    sumOfSquares.fill(0.0);
+    head = count = sinceResum = sinceClassified = 0;
+    prediction = {};
+}
+
+bool GestureClassifier::update(const GestureDetector& detector, size_t numNewSamples)
+{
+    const auto& history = detector.getHistory();
+
+    // The detector restarted its history (e.g. switched motion source), so start over with it
+    if (numNewSamples > history.size())
+    {
+        reset();
+        numNewSamples = history.size();
+    }
+
+    // Only the newest window's worth can still be in the window afterwards
+    const size_t skipped = numNewSamples > windowSamples ? numNewSamples - windowSamples : 0;
+    const size_t numToPush = numNewSamples - skipped;
+
+    for (int axis = 0; axis < numAxes; ++axis)
+    {
+        const float* input = history.window(static_cast<GestureDetector::History::Axis>(axis), numToPush);
+        float* lane = ring.data() + static_cast<size_t>(axis) * windowSamples;
+        double axisSum = sum[static_cast<size_t>(axis)];
+        double axisSquares = sumOfSquares[static_cast<size_t>(axis)];
+        size_t slot = head;
+
+        // Slots not yet written hold 0, so the window fills without a branch
+        for (size_t i = 0; i < numToPush; ++i)
+        {
+            const double outgoing = lane[slot];
+            const double incoming = input[i];
+            axisSum += incoming - outgoing;
+            axisSquares += incoming * incoming - outgoing * outgoing;
+            lane[slot] = input[i];
+
+            if (++slot == windowSamples)
+                slot = 0;
+        }
+
+        sum[static_cast<size_t>(axis)] = axisSum;
+        sumOfSquares[static_cast<size_t>(axis)] = axisSquares;
+    }
+
+    head = (head + numToPush) % windowSamples;
+    count = std::min(count + numToPush, windowSamples);
+
+    // Running sums drift by rounding; rebuild them from the ring once per window
+    sinceResum += numToPush;
+    if (sinceResum >= windowSamples)
+        resum();
+
+    sinceClassified += numNewSamples;
+
+    if (model == nullptr || count < windowSamples || sinceClassified < hopSize)
+        return false;
+
+    sinceClassified = 0;
+    computeFeatures(detector);
+    classify();
+    prediction.timestamp = history.latestTimestamp();
+    return true;
+}
+
+void GestureClassifier::resum()
+{
+    sinceResum = 0;
+
+    for (int axis = 0; axis < numAxes; ++axis)
+    {
+        const float* lane = ring.data() + static_cast<size_t>(axis) * windowSamples;
+        double axisSum = 0.0, axisSquares = 0.0;
+
+        for (size_t i = 0; i < windowSamples; ++i)
+        {
+            axisSum += lane[i];
+            axisSquares += static_cast<double>(lane[i]) * lane[i];
+        }
+
+        sum[static_cast<size_t>(axis)] = axisSum;
+        sumOfSquares[static_cast<size_t>(axis)] = axisSquares;
+    }
+}
+
+void GestureClassifier::computeFeatures(const GestureDetector& detector)
+{
+    // Same definitions as GestureRecorder::addFeatures(): mean, population variance, sum of squares
+    const double n = static_cast<double>(windowSamples);
+    size_t feature = 0;
+
+    for (int axis = 0; axis < numAxes; ++axis)
+    {
+        const double mean = sum[static_cast<size_t>(axis)] / n;
+        const double variance = std::max(0.0, sumOfSquares[static_cast<size_t>(axis)] / n - mean * mean);
+
+        features[feature++] = static_cast<float>(mean);
+        features[feature++] = static_cast<float>(variance);
+        features[feature++] = static_cast<float>(sumOfSquares[static_cast<size_t>(axis)]);
+    }
+
+    const auto& wavelets = detector.getWaveletEnergies();
+    for (int axis = 0; axis < WaveletEnergies::numAxes; ++axis)
+    {
+        for (int level = 0; level < CSVLogger::waveletLevels; ++level)
+        {
+            features[feature++] = level < wavelets.getNumLevels() ? wavelets.getEnergy(axis, level) : 0.0f;
+        }
+    }
+}
+
+void GestureClassifier::classify()
+{
+    const Model& m = *model;
+    const size_t numFeatures = m.numFeatures;
+    const size_t numExamples = m.numExamples();
+
+    for (size_t f = 0; f < numFeatures; ++f)
+        query[f] = (features[f] - m.mean[f]) * m.scale[f];
+
+    // k best so far, nearest first
+    const int k = static_cast<int>(std::min<size_t>(static_cast<size_t>(m.k), numExamples));
+    std::array<float, maxK> nearestDistance;
+    std::array<int, maxK> nearestLabel;
+    int found = 0;
+
+    constexpr size_t chunk = 8; // Features summed between early-exit checks, so the inner loop vectorises
+
+    for (size_t e = 0; e < numExamples; ++e)
+    {
+        const float* example = m.examples.data() + e * numFeatures;
+        const float limit = found == k ? nearestDistance[static_cast<size_t>(k - 1)]
+                                       : std::numeric_limits<float>::max();
+        float distance = 0.0f;
+
+        for (size_t f = 0; f < numFeatures && distance < limit; f += chunk)
+        {
+            const size_t end = std::min(numFeatures, f + chunk);
+            for (size_t i = f; i < end; ++i)
+            {
+                const float difference = query[i] - example[i];
+                distance += difference * difference;
+            }
+        }
+
+        if (distance >= limit)
+            continue;
+
+        // Insert in order, dropping the farthest once k are held
+        int slot = found < k ? found++ : k - 1;
+        while (slot > 0 && nearestDistance[static_cast<size_t>(slot - 1)] > distance)
+        {
+            nearestDistance[static_cast<size_t>(slot)] = nearestDistance[static_cast<size_t>(slot - 1)];
+            nearestLabel[static_cast<size_t>(slot)] = nearestLabel[static_cast<size_t>(slot - 1)];
+            --slot;
+        }
+
+        nearestDistance[static_cast<size_t>(slot)] = distance;
+        nearestLabel[static_cast<size_t>(slot)] = m.exampleLabels[e];
+    }
+
+    // Majority vote; a tie goes to the class that reached the count with nearer neighbours
+    std::array<int, maxLabels> votes{};
+    int winner = -1, winnerVotes = 0;
+
+    for (int i = 0; i < found; ++i)
+    {
+        const int label = nearestLabel[static_cast<size_t>(i)];
+        if (++votes[static_cast<size_t>(label)] > winnerVotes)
+        {
+            winner = label;
+            winnerVotes = votes[static_cast<size_t>(label)];
+        }
+    }
+
+    prediction.classIndex = winner;
+    prediction.confidence = found > 0 ? static_cast<float>(winnerVotes) / static_cast<float>(found) : 0.0f;
+}
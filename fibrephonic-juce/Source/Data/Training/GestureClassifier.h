@@ -0,0 +1,120 @@
+/**
+ * @file GestureClassifier.h
+ * @brief Runtime k-nearest-neighbour classifier for models recorded with GestureRecorder
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include <vector>
+#include "../GestureDetector.h"
+
+/**
+ * @class GestureClassifier
+ * @brief Classifies the live sensor window using feature rows saved by CSVLogger
+ *
+ * The model is the recorder's CSV itself: every labelled row becomes a
+ * reference example, z-score normalised per feature at load time. Columns are
+ * matched by header name, so files from before a feature was added still load
+ * (the missing features are simply ignored when measuring distance).
+ *
+ * At runtime the same features are kept up to date incrementally: running
+ * sums over the last CSVLogger::featureWindowSamples samples give each axis'
+ * mean, variance and energy in constant time per sample, and the wavelet
+ * energies are read from the detector as the recorder does. Every hop the
+ * window is classified by majority vote of its k nearest examples, with a
+ * partial-distance early exit once an example can no longer make the top k.
+ *
+ * All working storage is sized at construction or load, so update() never
+ * allocates. Single-threaded: owned and used by one GestureManager's
+ * processing thread. Models are immutable once loaded and may be shared by
+ * several classifiers.
+ */
+class GestureClassifier
+{
+public:
+    /** Limits that keep the vote on the stack */
+    static constexpr int maxK = 15;
+    static constexpr int maxLabels = 32;
+
+    /** @brief Reference examples and per-feature normalisation, as loaded from a recorder CSV */
+    struct Model
+    {
+        juce::StringArray labels;           ///< Class names, indexed by Prediction::classIndex
+        size_t numFeatures = 0;             ///< CSVLogger::getFeatureNames().size()
+        std::vector<float> mean;            ///< Per feature
+        std::vector<float> scale;           ///< Per feature 1/std; 0 for features absent or constant in the file
+        std::vector<float> examples;        ///< numExamples() rows of numFeatures, normalised
+        std::vector<int> exampleLabels;     ///< Index into labels, per example
+        int k = 5;
+
+        size_t numExamples() const { return exampleLabels.size(); }
+    };
+
+    /**
+     * @brief Build a model from a CSV written by CSVLogger
+     * @returns nullptr (with a DBG message) if the file is missing, has no
+     *          recognised feature columns or no labelled rows
+     */
+    static std::shared_ptr<const Model> loadModel(const juce::File& csvFile, int k = 5);
+
+    struct Prediction
+    {
+        int classIndex = -1;         ///< -1 until the first window has been classified
+        float confidence = 0.0f;     ///< Share of the k neighbours that voted for the class
+        uint64_t timestamp = 0;      ///< Device time of the newest sample in the window (us)
+    };
+
+    GestureClassifier();
+
+    /** @brief Swap in a model (or nullptr to stop classifying); the window is kept */
+    void setModel(std::shared_ptr<const Model> newModel);
+    const Model* getModel() const { return model.get(); }
+
+    /** @brief Samples between classifications */
+    void setHopSize(size_t samples) { hopSize = juce::jmax<size_t>(1, samples); }
+
+    /** @brief Forget the window, e.g. after a gap in the stream */
+    void reset();
+
+    /**
+     * @brief Bring the window up to date after the detector has taken numNewSamples
+     * @returns true if a new prediction was made
+     */
+    bool update(const GestureDetector& detector, size_t numNewSamples);
+
+    const Prediction& getPrediction() const { return prediction; }
+
+    /** @brief Current window features, in CSVLogger column order */
+    const std::vector<float>& getFeatures() const { return features; }
+
+private:
+    static constexpr int numAxes = GestureDetector::History::NumAxes;
+    static constexpr int featuresPerAxis = 3;   ///< mean, variance, energy
+
+    std::shared_ptr<const Model> model;
+
+    // Per-axis ring of the last windowSamples values, with running sums
+    size_t windowSamples;
+    std::vector<float> ring;                    ///< [axis][windowSamples]
+    std::array<double, numAxes> sum{};
+    std::array<double, numAxes> sumOfSquares{};
+    size_t head = 0;
+    size_t count = 0;
+    size_t sinceResum = 0;
+
+    size_t hopSize = 50;
+    size_t sinceClassified = 0;
+
+    std::vector<float> features;                ///< Raw, in CSV column order
+    std::vector<float> query;                   ///< Normalised features
+    Prediction prediction;
+
+    void resum();
+    void computeFeatures(const GestureDetector& detector);
+    void classify();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GestureClassifier)
+};
@@ -2,13 +2,15 @@
 #pragma once
 #include <JuceHeader.h>
 #include "../../Helpers.h"
-#include "../TextileGestureDetector.h"
+#include "../GestureDetector.h"
 #include <numeric>
 
 struct FeatureVector
 {
     std::vector<float> values;
     std::string label;
+    uint64_t startTime = 0; // Device timestamp of the first sample in the window (us)
+    uint64_t endTime = 0;   // Device timestamp of the last sample in the window (us)
 };
 
 class CSVLogger
@@ -16,6 +18,9 @@ class CSVLogger
 public:
     CSVLogger(const juce::File& file) : csvFile(file)
     {
+        if (csvFile.existsAsFile() && readHeaderLine() != getHeaderLine())
+            setAsideOutdatedFile();
+        
         if (!csvFile.existsAsFile())
         {
             csvFile.create();
@@ -23,25 +28,60 @@ public:
         }
     }
     
-    void writeHeader()
+    /** Samples per feature window (fewer only if the history is shorter) */
+    static constexpr size_t featureWindowSamples = 200;
+    
+    /** Levels written per axis - matches the detector's default WaveletEnergies */
+    static constexpr int waveletLevels = 4;
+    
+    /** Feature column names, in the order extractWindowFeatures() produces them */
+    static std::vector<std::string> getFeatureNames()
     {
-        // Write CSV header with all feature names
-        juce::StringArray header;
+        std::vector<std::string> names;
         
         // 9 sensors x 3 features each = 27 features
-        std::vector<std::string> sensors = {"ax", "ay", "az", "gx", "gy", "gz", "mx", "my", "mz"};
-        std::vector<std::string> features = {"mean", "variance", "energy"};
+        const std::vector<std::string> sensors = {"ax", "ay", "az", "gx", "gy", "gz", "mx", "my", "mz"};
+        const std::vector<std::string> features = {"mean", "variance", "energy"};
         
         for (const auto& sensor : sensors)
         {
             for (const auto& feature : features)
             {
-                header.add(juce::String(sensor + "_" + feature));
+                names.push_back(sensor + "_" + feature);
             }
         }
+        
+        // Wavelet detail energy per accel/gyro axis and level, finest first
+        for (int axis = 0; axis < WaveletEnergies::numAxes; ++axis)
+        {
+            for (int level = 1; level <= waveletLevels; ++level)
+            {
+                names.push_back(sensors[static_cast<size_t>(axis)] + "_wd" + std::to_string(level));
+            }
+        }
+        
+        return names;
+    }
+    
+    /** The CSV header: every feature name, then the window times and the label */
+    static juce::String getHeaderLine()
+    {
+        juce::StringArray header;
+        
+        for (const auto& name : getFeatureNames())
+            header.add(juce::String(name));
+        
+        header.add("t_start_us");
+        header.add("t_end_us");
         header.add("label");
         
-        juce::String headerLine = header.joinIntoString(",");
+        return header.joinIntoString(",");
+    }
+    
+    void writeHeader()
+    {
+        // Write CSV header with all feature names
+        const juce::String headerLine = getHeaderLine();
         juce::FileOutputStream stream(csvFile, false); // overwrite mode for header
         if (stream.openedOk())
         {
@@ -56,6 +96,8 @@ public:
         for (auto v : fv.values)
             row.add(juce::String(v, 6)); // 6 decimal places
         
+        row.add(juce::String(static_cast<juce::uint64>(fv.startTime)));
+        row.add(juce::String(static_cast<juce::uint64>(fv.endTime)));
         row.add(fv.label);
         juce::String line = row.joinIntoString(",");
         
@@ -67,6 +109,80 @@ public:
         }
     }
     
+private:
+    juce::File csvFile;
+    
+    juce::String readHeaderLine() const
+    {
+        juce::FileInputStream stream(csvFile);
+        return stream.openedOk() ? stream.readNextLine().trim() : juce::String();
+    }
+    
+    // A file recorded with a different feature set (e.g. before the wavelet columns) can't
+    // take new rows: they wouldn't match its header and the classifier would skip them all.
+    // Move it aside, keeping its samples, and start afresh under the original name.
+    void setAsideOutdatedFile()
+    {
+        const auto outdated = csvFile.getSiblingFile(csvFile.getFileNameWithoutExtension() + "-outdated"
+                                                     + csvFile.getFileExtension()).getNonexistentSibling();
+        
+        if (csvFile.moveFileTo(outdated))
+        {
+            DBG("Feature columns have changed - moved " << csvFile.getFileName()
+                << " to " << outdated.getFileName() << " and started a new file");
+        }
+        else
+        {
+            csvFile = csvFile.getNonexistentSibling();
+            DBG("Feature columns have changed - recording to " << csvFile.getFileName() << " instead");
+        }
+    }
+};
+
+/**
+ * Writes the raw accel/gyro samples of each recorded window, one row per
+ * sample, for TemplateMatcher. Rows sharing a t_start_us form one template.
+ */
+class TemplateLogger
+{
+public:
+    TemplateLogger(const juce::File& file) : csvFile(file)
+    {
+        if (!csvFile.existsAsFile())
+        {
+            csvFile.create();
+            
+            juce::FileOutputStream stream(csvFile, false);
+            if (stream.openedOk())
+            {
+                stream.writeText("t_start_us,t_us,ax,ay,az,gx,gy,gz,label\n", false, false, "\n");
+            }
+        }
+    }
+    
+    void logTemplate(const GestureDetector::History& history, size_t windowSize, const std::string& label)
+    {
+        const uint64_t* timestamps = history.timestampWindow(windowSize);
+        juce::String text;
+        
+        for (size_t i = 0; i < windowSize; ++i)
+        {
+            text << juce::String(static_cast<juce::uint64>(timestamps[0])) << ","
+                 << juce::String(static_cast<juce::uint64>(timestamps[i]));
+            
+            for (int axis = GestureDetector::History::AccelX; axis <= GestureDetector::History::GyroZ; ++axis)
+                text << "," << juce::String(history.window(static_cast<GestureDetector::History::Axis>(axis), windowSize)[i], 6);
+            
+            text << "," << label << "\n";
+        }
+        
+        juce::FileOutputStream stream(csvFile, true); // append mode
+        if (stream.openedOk())
+        {
+            stream.writeText(text, false, false, "\n");
+        }
+    }
+    
 private:
     juce::File csvFile;
 };
@@ -74,8 +190,9 @@ private:
 class GestureRecorder : public juce::Component, private juce::Timer
 {
 public:
-    GestureRecorder(TextileGestureDetector& detectorRef, CSVLogger& loggerRef)
-        : detector(detectorRef), logger(loggerRef)
+    /** @param templateLoggerPtr Optional; also saves each window's raw samples as a DTW template */
+    GestureRecorder(GestureDetector& detectorRef, CSVLogger& loggerRef, TemplateLogger* templateLoggerPtr = nullptr)
+        : detector(detectorRef), logger(loggerRef), templateLogger(templateLoggerPtr)
     {
         setupUI();
     }
@@ -219,7 +336,7 @@ private:
     void saveWindow()
     {
         // Use a larger window size to capture the full gesture
-        size_t windowSize = std::min(static_cast<size_t>(200), detector.getBuffer().size());
+        size_t windowSize = std::min(CSVLogger::featureWindowSamples, detector.getHistory().size());
         
         if (windowSize < 10) // Need minimum samples
         {
@@ -227,11 +344,15 @@ private:
             return;
         }
         
-        auto fv = extractWindowFeatures(detector.getBuffer(), windowSize, currentLabel);
+        auto fv = extractWindowFeatures(detector.getHistory(), windowSize, currentLabel);
         
         if (!fv.values.empty())
         {
             logger.logFeature(fv);
+            
+            if (templateLogger != nullptr)
+                templateLogger->logTemplate(detector.getHistory(), windowSize, currentLabel);
+            
             DBG("Saved gesture: " << currentLabel << " with " << fv.values.size() << " features");
         }
         else
@@ -240,55 +361,49 @@ private:
         }
     }
     
-    FeatureVector extractWindowFeatures(const std::deque<IMUData>& buffer,
+    FeatureVector extractWindowFeatures(const GestureDetector::History& history,
                                         size_t windowSize,
                                         const std::string& label)
     {
         FeatureVector fv;
         fv.label = label;
 
-        if (buffer.size() < windowSize)
+        if (history.size() < windowSize)
         {
-            DBG("Buffer too small: " << buffer.size() << " < " << windowSize);
+            DBG("Buffer too small: " << history.size() << " < " << windowSize);
             return fv;
         }
 
-        // Collect last windowSize samples
-        std::vector<float> ax, ay, az, gx, gy, gz, mx, my, mz;
-        
-        size_t startIndex = buffer.size() - windowSize;
-        for (size_t i = startIndex; i < buffer.size(); ++i)
+        // The last windowSize samples of each axis are contiguous in the history
+        const uint64_t* timestamps = history.timestampWindow(windowSize);
+        fv.startTime = timestamps[0];
+        fv.endTime = timestamps[windowSize - 1];
+
+        // Extract features for each sensor axis
+        for (int axis = 0; axis < GestureDetector::History::NumAxes; ++axis)
         {
-            const auto& d = buffer[i];
-            ax.push_back(d.accelX);
-            ay.push_back(d.accelY);
-            az.push_back(d.accelZ);
-            gx.push_back(d.gyroX);
-            gy.push_back(d.gyroY);
-            gz.push_back(d.gyroZ);
-            mx.push_back(d.magX);
-            my.push_back(d.magY);
-            mz.push_back(d.magZ);
+            addFeatures(fv.values,
+                        history.window(static_cast<GestureDetector::History::Axis>(axis), windowSize),
+                        windowSize);
         }
 
-        // Extract features for each sensor axis
-        addFeatures(fv.values, ax);
-        addFeatures(fv.values, ay);
-        addFeatures(fv.values, az);
-        addFeatures(fv.values, gx);
-        addFeatures(fv.values, gy);
-        addFeatures(fv.values, gz);
-        addFeatures(fv.values, mx);
-        addFeatures(fv.values, my);
-        addFeatures(fv.values, mz);
+        // Wavelet energies are maintained sample by sample by the detector; take them as they stand
+        const auto& wavelets = detector.getWaveletEnergies();
+        for (int axis = 0; axis < WaveletEnergies::numAxes; ++axis)
+        {
+            for (int level = 0; level < CSVLogger::waveletLevels; ++level)
+            {
+                fv.values.push_back(level < wavelets.getNumLevels() ? wavelets.getEnergy(axis, level) : 0.0f);
+            }
+        }
 
         DBG("Extracted " << fv.values.size() << " features from " << windowSize << " samples");
         return fv;
     }
     
-    void addFeatures(std::vector<float>& dest, const std::vector<float>& data)
+    void addFeatures(std::vector<float>& dest, const float* data, size_t size)
     {
-        if (data.empty())
+        if (size == 0)
         {
             dest.push_back(0.0f); // mean
             dest.push_back(0.0f); // variance
@@ -297,18 +412,18 @@ private:
         }
         
         // Mean
-        float mean = std::accumulate(data.begin(), data.end(), 0.0f) / data.size();
+        float mean = std::accumulate(data, data + size, 0.0f) / size;
         
         // Variance
         float variance = 0.0f;
-        for (auto v : data)
-            variance += (v - mean) * (v - mean);
-        variance /= data.size();
+        for (size_t i = 0; i < size; ++i)
+            variance += (data[i] - mean) * (data[i] - mean);
+        variance /= size;
         
         // Energy (sum of squares)
         float energy = 0.0f;
-        for (auto v : data)
-            energy += v * v;
+        for (size_t i = 0; i < size; ++i)
+            energy += data[i] * data[i];
         
         dest.push_back(mean);
         dest.push_back(variance);
@@ -316,8 +431,9 @@ private:
     }
 
     // References
-    TextileGestureDetector& detector;
+    GestureDetector& detector;
     CSVLogger& logger;
+    TemplateLogger* templateLogger;
 
     // UI Components
     juce::ComboBox gestureComboBox;
@@ -0,0 +1,384 @@
+/**
+ * @file TemplateMatcher.cpp
+ * @brief Dynamic time warping against a library of gesture templates recorded with GestureRecorder
+ */
+
+#include "TemplateMatcher.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+    constexpr float infinity = std::numeric_limits<float>::max();
+
+    /** Area-average n samples down (or up) to templateLength points, then remove the mean */
+    void resampleChannel(const float* input, size_t n, float* output)
+    {
+        constexpr size_t length = TemplateMatcher::templateLength;
+        float mean = 0.0f;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            const size_t start = std::min(n - 1, i * n / length);
+            const size_t end = std::max(start + 1, (i + 1) * n / length);
+
+            float sum = 0.0f;
+            for (size_t j = start; j < end; ++j)
+                sum += input[j];
+
+            output[i] = sum / static_cast<float>(end - start);
+            mean += output[i];
+        }
+
+        mean /= static_cast<float>(length);
+        for (size_t i = 0; i < length; ++i)
+            output[i] -= mean;
+    }
+
+    /** Running max and min of values within band points either side - the LB_Keogh envelope */
+    void buildEnvelope(const float* values, int band, float* upper, float* lower)
+    {
+        constexpr int length = TemplateMatcher::templateLength;
+
+        for (int i = 0; i < length; ++i)
+        {
+            const int first = std::max(0, i - band);
+            const int last = std::min(length - 1, i + band);
+            upper[i] = *std::max_element(values + first, values + last + 1);
+            lower[i] = *std::min_element(values + first, values + last + 1);
+        }
+    }
+
+    /** Squared distance of each value from outside its envelope (0 inside) */
+    inline float outsideEnvelope(float value, float upper, float lower)
+    {
+        const float outside = std::max(value - upper, 0.0f) + std::max(lower - value, 0.0f);
+        return outside * outside;
+    }
+
+    const char* const channelNames[TemplateMatcher::numChannels] = { "ax", "ay", "az", "gx", "gy", "gz" };
+}
+
+std::shared_ptr<const TemplateMatcher::Library> TemplateMatcher::loadLibrary(const juce::File& csvFile, float bandFraction)
+{
+    if (!csvFile.existsAsFile())
+    {
+        DBG("Template library not found: " << csvFile.getFullPathName());
+        return nullptr;
+    }
+
+    juce::StringArray lines;
+    csvFile.readLines(lines);
+    lines.removeEmptyStrings();
+
+    const auto header = lines.isEmpty() ? juce::StringArray() : juce::StringArray::fromTokens(lines[0], ",", "\"");
+    const int startColumn = header.indexOf("t_start_us");
+    const int timeColumn = header.indexOf("t_us");
+    const int labelColumn = header.indexOf("label");
+
+    std::array<int, numChannels> channelColumns;
+    bool hasColumns = startColumn >= 0 && timeColumn >= 0 && labelColumn >= 0;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        channelColumns[static_cast<size_t>(channel)] = header.indexOf(channelNames[channel]);
+        hasColumns = hasColumns && channelColumns[static_cast<size_t>(channel)] >= 0;
+    }
+
+    if (!hasColumns)
+    {
+        DBG("Template library is missing columns: " << csvFile.getFullPathName());
+        return nullptr;
+    }
+
+    auto library = std::make_shared<Library>();
+    constexpr size_t length = static_cast<size_t>(templateLength);
+    constexpr size_t stride = static_cast<size_t>(numChannels) * length;
+
+    std::vector<double> durations;
+    std::array<std::vector<float>, numChannels> raw;
+    juce::String currentStart, currentLabel;
+    uint64_t firstTime = 0, lastTime = 0;
+
+    // Rows of one recording are consecutive and share a start time
+    auto finishTemplate = [&]
+    {
+        const size_t n = raw[0].size();
+        if (n > 1 && currentLabel.isNotEmpty())
+        {
+            int labelIndex = library->labels.indexOf(currentLabel);
+            if (labelIndex < 0)
+            {
+                library->labels.add(currentLabel);
+                labelIndex = library->labels.size() - 1;
+            }
+
+            const size_t offset = library->templates.size();
+            library->templates.resize(offset + stride);
+            for (int channel = 0; channel < numChannels; ++channel)
+                resampleChannel(raw[static_cast<size_t>(channel)].data(), n,
+                                library->templates.data() + offset + static_cast<size_t>(channel) * length);
+
+            library->templateLabels.push_back(labelIndex);
+            durations.push_back(static_cast<double>(lastTime - firstTime) * 1.0e-6 * static_cast<double>(n) / static_cast<double>(n - 1));
+        }
+
+        for (auto& channel : raw)
+            channel.clear();
+    };
+
+    for (int line = 1; line < lines.size(); ++line)
+    {
+        const auto tokens = juce::StringArray::fromTokens(lines[line], ",", "\"");
+        if (tokens.size() != header.size())
+            continue;
+
+        const auto start = tokens[startColumn].trim();
+        const auto label = tokens[labelColumn].trim();
+        const auto time = static_cast<uint64_t>(tokens[timeColumn].getLargeIntValue());
+
+        if (start != currentStart || label != currentLabel)
+        {
+            finishTemplate();
+            currentStart = start;
+            currentLabel = label;
+            firstTime = time;
+        }
+
+        lastTime = time;
+        for (int channel = 0; channel < numChannels; ++channel)
+            raw[static_cast<size_t>(channel)].push_back(tokens[channelColumns[static_cast<size_t>(channel)]].getFloatValue());
+    }
+
+    finishTemplate();
+
+    const size_t numTemplates = library->numTemplates();
+    if (numTemplates == 0)
+    {
+        DBG("Template library holds no templates: " << csvFile.getFullPathName());
+        return nullptr;
+    }
+
+    // Scale each channel by its spread over the whole library so no unit dominates
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        double squares = 0.0;
+        for (size_t t = 0; t < numTemplates; ++t)
+        {
+            const float* values = library->templates.data() + t * stride + static_cast<size_t>(channel) * length;
+            for (size_t i = 0; i < length; ++i)
+                squares += static_cast<double>(values[i]) * values[i];
+        }
+
+        const double spread = std::sqrt(squares / static_cast<double>(numTemplates * length));
+        const float scale = spread > 1.0e-9 ? static_cast<float>(1.0 / spread) : 0.0f;
+        library->channelScale[static_cast<size_t>(channel)] = scale;
+
+        for (size_t t = 0; t < numTemplates; ++t)
+        {
+            float* values = library->templates.data() + t * stride + static_cast<size_t>(channel) * length;
+            for (size_t i = 0; i < length; ++i)
+                values[i] *= scale;
+        }
+    }
+
+    // LB_Keogh envelopes: the range each template point can be warped across
+    library->band = juce::jlimit(1, templateLength - 1, juce::roundToInt(bandFraction * templateLength));
+    library->upper.resize(library->templates.size());
+    library->lower.resize(library->templates.size());
+
+    for (size_t row = 0; row < numTemplates * static_cast<size_t>(numChannels); ++row)
+    {
+        buildEnvelope(library->templates.data() + row * length, library->band,
+                      library->upper.data() + row * length, library->lower.data() + row * length);
+    }
+
+    std::nth_element(durations.begin(), durations.begin() + static_cast<std::ptrdiff_t>(durations.size() / 2), durations.end());
+    library->durationSeconds = durations[durations.size() / 2];
+
+    DBG("Template library: " << (int) numTemplates << " templates, " << library->labels.size() << " gestures, "
+        << library->durationSeconds << " s, from " << csvFile.getFileName());
+
+    return library;
+}
+
+void TemplateMatcher::setLibrary(std::shared_ptr<const Library> newLibrary)
+{
+    library = std::move(newLibrary);
+
+    const size_t numTemplates = library ? library->numTemplates() : 0;
+    lowerBounds.assign(numTemplates, 0.0f);
+    order.resize(numTemplates);
+    std::iota(order.begin(), order.end(), 0);
+
+    match = {};
+    sinceMatched = 0;
+    lastWarpCount = 0;
+}
+
+bool TemplateMatcher::update(const GestureDetector& detector, size_t numNewSamples)
+{
+    sinceMatched += numNewSamples;
+
+    if (library == nullptr || sinceMatched < hopSize)
+        return false;
+
+    // The window spans the templates' duration at whatever rate is streaming now
+    const auto& history = detector.getHistory();
+    const double samples = library->durationSeconds * static_cast<double>(detector.getSampleRate());
+    const size_t windowSamples = juce::jlimit<size_t>(static_cast<size_t>(templateLength),
+                                                      GestureDetector::historyCapacity,
+                                                      static_cast<size_t>(std::lround(samples)));
+
+    if (history.size() < windowSamples)
+        return false;
+
+    sinceMatched = 0;
+    prepareQuery(detector, windowSamples);
+
+    const size_t numTemplates = library->numTemplates();
+    for (size_t t = 0; t < numTemplates; ++t)
+        lowerBounds[t] = lowerBound(t);
+
+    std::sort(order.begin(), order.end(), [this](int a, int b)
+    {
+        return lowerBounds[static_cast<size_t>(a)] < lowerBounds[static_cast<size_t>(b)];
+    });
+
+    // Nearest bounds first; once a bound passes the best distance, so do all that follow
+    float best = infinity;
+    int bestTemplate = -1;
+    lastWarpCount = 0;
+
+    for (int t : order)
+    {
+        if (lowerBounds[static_cast<size_t>(t)] >= best)
+            break;
+
+        ++lastWarpCount;
+        const float distance = warpedDistance(static_cast<size_t>(t), best);
+        if (distance < best)
+        {
+            best = distance;
+            bestTemplate = t;
+        }
+    }
+
+    // Nothing finite to compare against (e.g. a NaN in the window) - keep the previous match
+    if (bestTemplate < 0)
+        return false;
+
+    match.templateIndex = bestTemplate;
+    match.labelIndex = library->templateLabels[static_cast<size_t>(bestTemplate)];
+    match.distance = best / static_cast<float>(templateLength);
+    match.timestamp = history.latestTimestamp();
+    return true;
+}
+
+void TemplateMatcher::prepareQuery(const GestureDetector& detector, size_t windowSamples)
+{
+    const auto& history = detector.getHistory();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* values = query.data() + static_cast<size_t>(channel * templateLength);
+        resampleChannel(history.window(static_cast<GestureDetector::History::Axis>(channel), windowSamples),
+                        windowSamples, values);
+
+        const float scale = library->channelScale[static_cast<size_t>(channel)];
+        for (int i = 0; i < templateLength; ++i)
+            values[i] *= scale;
+
+        buildEnvelope(values, library->band,
+                      queryUpper.data() + channel * templateLength, queryLower.data() + channel * templateLength);
+    }
+}
+
+float TemplateMatcher::lowerBound(size_t templateIndex) const
+{
+    // LB_Keogh: how far the query strays outside the template's warping envelope,
+    // and the template outside the query's; either bounds the DTW distance
+    const size_t offset = templateIndex * static_cast<size_t>(numChannels * templateLength);
+    const float* candidate = library->templates.data() + offset;
+    const float* upper = library->upper.data() + offset;
+    const float* lower = library->lower.data() + offset;
+
+    float queryBound = 0.0f, candidateBound = 0.0f;
+    for (int i = 0; i < numChannels * templateLength; ++i)
+    {
+        queryBound += outsideEnvelope(query[static_cast<size_t>(i)], upper[i], lower[i]);
+        candidateBound += outsideEnvelope(candidate[i], queryUpper[static_cast<size_t>(i)], queryLower[static_cast<size_t>(i)]);
+    }
+
+    return std::max(queryBound, candidateBound);
+}
+
+float TemplateMatcher::warpedDistance(size_t templateIndex, float bestSoFar)
+{
+    const size_t offset = templateIndex * static_cast<size_t>(numChannels * templateLength);
+    const float* candidate = library->templates.data() + offset;
+    const float* upper = library->upper.data() + offset;
+    const float* lower = library->lower.data() + offset;
+    const int band = library->band;
+
+    // Every path pays at least the LB_Keogh term of each query row still to come
+    std::fill(remainingBound.begin(), remainingBound.end(), 0.0f);
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const int start = channel * templateLength;
+        for (int i = 0; i < templateLength; ++i)
+            remainingBound[static_cast<size_t>(i)] += outsideEnvelope(query[static_cast<size_t>(start + i)],
+                                                                      upper[start + i], lower[start + i]);
+    }
+    for (int i = templateLength - 1; i >= 0; --i)
+        remainingBound[static_cast<size_t>(i)] += remainingBound[static_cast<size_t>(i + 1)];
+
+    float* previous = previousRow.data();
+    float* current = currentRow.data();
+    std::fill(previousRow.begin(), previousRow.end(), infinity);
+    std::fill(currentRow.begin(), currentRow.end(), infinity);
+    previous[0] = 0.0f;
+
+    for (int i = 1; i <= templateLength; ++i)
+    {
+        const int first = std::max(1, i - band);
+        const int last = std::min(templateLength, i + band);
+
+        // Squared distance from query point i to each template point in the band, summed over channels
+        std::fill(cellCost.begin() + (first - 1), cellCost.begin() + last, 0.0f);
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const float q = query[static_cast<size_t>(channel * templateLength + i - 1)];
+            const float* values = candidate + channel * templateLength;
+            for (int j = first - 1; j < last; ++j)
+            {
+                const float difference = q - values[j];
+                cellCost[static_cast<size_t>(j)] += difference * difference;
+            }
+        }
+
+        // Only the cells either side of the band are read outside it, and those stay unreachable
+        current[first - 1] = infinity;
+        if (last < templateLength)
+            current[last + 1] = infinity;
+
+        float rowMinimum = infinity;
+
+        for (int j = first; j <= last; ++j)
+        {
+            const float cell = cellCost[static_cast<size_t>(j - 1)]
+                             + std::min(std::min(previous[j - 1], previous[j]), current[j - 1]);
+            current[j] = cell;
+            rowMinimum = std::min(rowMinimum, cell);
+        }
+
+        // Every path crosses this row and all those after it, so none can finish below this
+        if (rowMinimum + remainingBound[static_cast<size_t>(i)] >= bestSoFar)
+            return infinity;
+
+        std::swap(previous, current);
+    }
+
+    return previous[templateLength];
+}
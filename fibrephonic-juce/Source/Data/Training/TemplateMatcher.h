@@ -0,0 +1,114 @@
+/**
+ * @file TemplateMatcher.h
+ * @brief Dynamic time warping against a library of gesture templates recorded with GestureRecorder
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include <vector>
+#include "../GestureDetector.h"
+
+/**
+ * @class TemplateMatcher
+ * @brief Finds the recorded gesture template nearest the live window under DTW
+ *
+ * Templates are the raw accel/gyro windows written by TemplateLogger. At load
+ * each is resampled to templateLength points, has its per-channel mean removed
+ * (so gravity and gyro bias don't count) and is scaled by the library-wide
+ * channel spread, putting g and deg/s on an equal footing. The live window is
+ * prepared the same way every hop, over the same duration as the templates at
+ * the current stream rate.
+ *
+ * Matching is 1-nearest-neighbour under multi-channel DTW in a Sakoe-Chiba
+ * band, pruned as in the UCR suite: LB_Keogh lower bounds both ways round
+ * (the live window against each template's precomputed envelope, and each
+ * template against the window's envelope) are computed for the whole library,
+ * templates are visited in order of the tighter bound until it exceeds the
+ * best distance so far, and each full DTW is abandoned as soon as the rows
+ * done plus the bound on the rows to come exceed it. Data is stored
+ * channel-major so every inner loop runs over contiguous floats and
+ * vectorises.
+ *
+ * All working storage is sized when a library is set, so update() never
+ * allocates. Single-threaded: owned and used by one GestureManager's
+ * processing thread. Libraries are immutable once loaded and may be shared.
+ */
+class TemplateMatcher
+{
+public:
+    static constexpr int numChannels = 6;       ///< AccelX..GyroZ
+    static constexpr int templateLength = 64;   ///< Points per resampled template
+
+    /** @brief Templates and their envelopes, as loaded from a TemplateLogger CSV */
+    struct Library
+    {
+        juce::StringArray labels;               ///< Gesture names, indexed by Match::labelIndex
+        std::vector<int> templateLabels;        ///< Index into labels, per template
+        std::vector<float> templates;           ///< [template][channel][templateLength], normalised
+        std::vector<float> upper, lower;        ///< LB_Keogh envelopes, same layout
+        std::array<float, numChannels> channelScale{};  ///< 1 / spread of each channel across the library
+        double durationSeconds = 0.0;           ///< Median template duration
+        int band = 6;                           ///< Sakoe-Chiba half-width, in points
+
+        size_t numTemplates() const { return templateLabels.size(); }
+    };
+
+    /**
+     * @brief Build a library from a CSV written by TemplateLogger
+     * @param bandFraction Warping allowed, as a fraction of the template length
+     * @returns nullptr (with a DBG message) if the file is missing or holds no templates
+     */
+    static std::shared_ptr<const Library> loadLibrary(const juce::File& csvFile, float bandFraction = 0.1f);
+
+    struct Match
+    {
+        int templateIndex = -1;      ///< -1 until the first window has been matched
+        int labelIndex = -1;
+        float distance = 0.0f;       ///< Warped squared distance per point, in channel spreads
+        uint64_t timestamp = 0;      ///< Device time of the newest sample in the window (us)
+    };
+
+    TemplateMatcher() = default;
+
+    /** @brief Swap in a library (or nullptr to stop matching) */
+    void setLibrary(std::shared_ptr<const Library> newLibrary);
+    const Library* getLibrary() const { return library.get(); }
+
+    /** @brief Samples between matches */
+    void setHopSize(size_t samples) { hopSize = juce::jmax<size_t>(1, samples); }
+
+    /**
+     * @brief Count the detector's newest samples and match once a hop has passed
+     * @returns true if a new match was made
+     */
+    bool update(const GestureDetector& detector, size_t numNewSamples);
+
+    const Match& getMatch() const { return match; }
+
+    /** @brief Templates that needed a full DTW on the last match - how well the bounds are pruning */
+    size_t getLastWarpCount() const { return lastWarpCount; }
+
+private:
+    std::shared_ptr<const Library> library;
+    size_t hopSize = 25;
+    size_t sinceMatched = 0;
+    Match match;
+    size_t lastWarpCount = 0;
+
+    std::array<float, numChannels * templateLength> query{};
+    std::array<float, numChannels * templateLength> queryUpper{}, queryLower{};
+    std::vector<float> lowerBounds;             ///< Per template
+    std::vector<int> order;                     ///< Templates by ascending lower bound
+    std::array<float, templateLength + 1> previousRow{}, currentRow{};
+    std::array<float, templateLength> cellCost{};
+    std::array<float, templateLength + 1> remainingBound{};  ///< LB_Keogh of query rows i.. against one template
+
+    void prepareQuery(const GestureDetector& detector, size_t windowSamples);
+    float lowerBound(size_t templateIndex) const;
+    float warpedDistance(size_t templateIndex, float bestSoFar);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TemplateMatcher)
+};
@@ -0,0 +1,82 @@
+/**
+ * @file WaveletEnergies.cpp
+ * @brief Streaming multi-level wavelet detail energies for the accel/gyro axes
+ */
+
+#include "WaveletEnergies.h"
+#include "../Wavelib/wavelet2s.h"
+#include <algorithm>
+
+WaveletEnergies::WaveletEnergies(const std::string& waveletName, int levels)
+    : numLevels(std::clamp(levels, 1, maxLevels))
+{
+    std::vector<double> lp1, hp1, lp2, hp2;
+    if (filtcoef(waveletName, lp1, hp1, lp2, hp2) != 0 || lp1.empty())
+    {
+        lp1.clear(); hp1.clear(); lp2.clear(); hp2.clear();
+        filtcoef("db2", lp1, hp1, lp2, hp2);
+    }
+
+    // Analysis filters, as swt() convolves with them
+    numTaps = static_cast<int>(lp1.size());
+    lowPass.assign(lp1.begin(), lp1.end());
+    highPass.assign(hp1.begin(), hp1.end());
+
+    // The deepest level reaches (taps - 1) * 2^(levels - 1) samples back
+    const size_t span = static_cast<size_t>(numTaps - 1) * (size_t(1) << (numLevels - 1)) + 1;
+    lineLength = 1;
+    while (lineLength < span)
+        lineLength <<= 1;
+
+    lines.assign(static_cast<size_t>(numAxes * numLevels) * lineLength, 0.0f);
+    energies.assign(static_cast<size_t>(numAxes * maxLevels), 0.0f);
+}
+
+void WaveletEnergies::setAveragingLength(float samples)
+{
+    alpha = std::min(1.0f, 1.0f / std::max(1.0f, samples));
+}
+
+void WaveletEnergies::reset()
+{
+    std::fill(lines.begin(), lines.end(), 0.0f);
+    std::fill(energies.begin(), energies.end(), 0.0f);
+    head = 0;
+}
+
+void WaveletEnergies::push(const float* values)
+{
+    const size_t mask = lineLength - 1;
+    const size_t slot = head & mask;
+
+    for (int axis = 0; axis < numAxes; ++axis)
+    {
+        float input = values[axis];
+        float* axisLines = lines.data() + static_cast<size_t>(axis * numLevels) * lineLength;
+        float* axisEnergies = energies.data() + axis * maxLevels;
+
+        for (int level = 0; level < numLevels; ++level)
+        {
+            float* line = axisLines + static_cast<size_t>(level) * lineLength;
+            line[slot] = input;
+
+            // Filter taps dilated to 2^level samples apart
+            const size_t stride = size_t(1) << level;
+            float approximation = 0.0f, detail = 0.0f;
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const float x = line[(head - static_cast<size_t>(k) * stride) & mask];
+                approximation += lowPass[static_cast<size_t>(k)] * x;
+                detail += highPass[static_cast<size_t>(k)] * x;
+            }
+
+            // Undo the sqrt(2)-per-level gain of the unnormalised approximations so a
+            // given signal power reads the same whichever level it lands in
+            const float power = detail * detail / static_cast<float>(size_t(1) << level);
+            axisEnergies[level] += alpha * (power - axisEnergies[level]);
+            input = approximation;
+        }
+    }
+
+    ++head;
+}
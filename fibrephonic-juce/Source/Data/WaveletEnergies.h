@@ -0,0 +1,72 @@
+/**
+ * @file WaveletEnergies.h
+ * @brief Streaming multi-level wavelet detail energies for the accel/gyro axes
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @class WaveletEnergies
+ * @brief Per-sample stationary wavelet transform with running energy per level
+ *
+ * An undecimated ("a trous") transform using the decomposition filters from
+ * Wavelib's filtcoef(): level j filters the level j-1 approximation with the
+ * taps spaced 2^j samples apart. Each level keeps a short delay line of its
+ * input, so one new sample costs levels x taps multiply-adds per axis - the
+ * causal counterpart of running swt() over the history, without ever
+ * re-transforming a window.
+ *
+ * The detail coefficients feed exponentially weighted energies: fine levels
+ * pick up fabric texture and tap transients, coarse levels strokes and
+ * handling. Detail filters reject DC, so gravity and gyro bias don't register.
+ *
+ * Storage is allocated once at construction. Single-threaded: owned and used
+ * by one GestureDetector.
+ */
+class WaveletEnergies
+{
+public:
+    static constexpr int numAxes = 6;    ///< AccelX..GyroZ, in SensorHistory::Axis order
+    static constexpr int maxLevels = 6;
+
+    /**
+     * @param waveletName Any name filtcoef() knows ("haar", "db2", "sym4", ...); unknown names fall back to db2
+     * @param levels      Decomposition depth, 1 to maxLevels
+     */
+    explicit WaveletEnergies(const std::string& waveletName = "db2", int levels = 4);
+
+    /** @brief Energy averaging length in samples (e.g. a quarter second's worth) */
+    void setAveragingLength(float samples);
+
+    /** @brief Clear the delay lines and energies */
+    void reset();
+
+    /** @brief Add one sample per axis (numAxes values) */
+    void push(const float* values);
+
+    int getNumLevels() const { return numLevels; }
+
+    /** @brief Running detail energy of one axis; level 0 is the finest (highest frequency) */
+    float getEnergy(int axis, int level) const { return energies[static_cast<size_t>(axis * maxLevels + level)]; }
+
+    /** @brief getNumLevels() energies for one axis, finest first */
+    const float* getEnergies(int axis) const { return energies.data() + axis * maxLevels; }
+
+private:
+    int numLevels;
+    int numTaps = 0;
+    size_t lineLength = 0;               ///< Per (axis, level) delay line, a power of two
+    size_t head = 0;                     ///< Samples pushed; shared by every line
+
+    std::vector<float> lowPass, highPass;
+    std::vector<float> lines;            ///< [axis][level][lineLength] level inputs
+    std::vector<float> energies;         ///< [axis][maxLevels]
+    float alpha = 0.01f;
+
+    WaveletEnergies(const WaveletEnergies&) = delete;
+    WaveletEnergies& operator=(const WaveletEnergies&) = delete;
+};
@@ -0,0 +1,504 @@
+/**
+ * @file Ximu3DeviceManager.cpp
+ * @brief Concurrent multi-device x-IMU3 ingest and processing
+ */
+
+#include "Ximu3DeviceManager.h"
+#include <iostream>
+
+//==============================================================================
+Ximu3DeviceManager::Device::Device(const juce::String& serialNumber)
+: juce::Thread("IMU Device " + serialNumber)
+, serial(serialNumber)
+, gestureManager("/device/" + serialNumber)
+{
+    inertialCallback = [this](auto message)
+    {
+        IMUData frame(message.accelerometer_x,
+                      message.accelerometer_y,
+                      message.accelerometer_z,
+                      message.gyroscope_x,
+                      message.gyroscope_y,
+                      message.gyroscope_z,
+                      magX.load(std::memory_order_relaxed),
+                      magY.load(std::memory_order_relaxed),
+                      magZ.load(std::memory_order_relaxed),
+                      message.timestamp);
+
+        if (fusionEnabled.load(std::memory_order_relaxed) && fusionReceived.load(std::memory_order_relaxed))
+        {
+            frame.linearAccelX = linearX.load(std::memory_order_relaxed);
+            frame.linearAccelY = linearY.load(std::memory_order_relaxed);
+            frame.linearAccelZ = linearZ.load(std::memory_order_relaxed);
+            frame.quatW = quatW.load(std::memory_order_relaxed);
+            frame.quatX = quatX.load(std::memory_order_relaxed);
+            frame.quatY = quatY.load(std::memory_order_relaxed);
+            frame.quatZ = quatZ.load(std::memory_order_relaxed);
+            frame.hasFusion = true;
+        }
+
+        pushSample(frame);
+    };
+
+    magnetometerCallback = [this](auto message)
+    {
+        magX.store(message.x, std::memory_order_relaxed);
+        magY.store(message.y, std::memory_order_relaxed);
+        magZ.store(message.z, std::memory_order_relaxed);
+    };
+
+    linearAccelerationCallback = [this](auto message)
+    {
+        linearX.store(message.acceleration_x, std::memory_order_relaxed);
+        linearY.store(message.acceleration_y, std::memory_order_relaxed);
+        linearZ.store(message.acceleration_z, std::memory_order_relaxed);
+        quatW.store(message.quaternion_w, std::memory_order_relaxed);
+        quatX.store(message.quaternion_x, std::memory_order_relaxed);
+        quatY.store(message.quaternion_y, std::memory_order_relaxed);
+        quatZ.store(message.quaternion_z, std::memory_order_relaxed);
+        fusionReceived.store(true, std::memory_order_relaxed);
+    };
+
+    statisticsCallback = [this](auto statistics)
+    {
+        gestureManager.getStats().recordLink(statistics);
+    };
+
+    startThread(juce::Thread::Priority::highest);
+}
+
+Ximu3DeviceManager::Device::~Device()
+{
+    close();
+
+    // Never time out: the thread owns gestureManager and block until run() returns
+    stopThread(-1);
+}
+
+void Ximu3DeviceManager::Device::open(const ximu3::ConnectionInfo& connectionInfo)
+{
+    connection = std::make_unique<ximu3::Connection>(connectionInfo);
+    connection->addInertialCallback(inertialCallback);
+    connection->addMagnetometerCallback(magnetometerCallback);
+    connection->addLinearAccelerationCallback(linearAccelerationCallback);
+    connection->addStatisticsCallback(statisticsCallback);
+
+    openStartMs = juce::Time::getMillisecondCounter();
+    connection->openAsync([state = openState](auto result)
+    {
+        state->store(result == ximu3::XIMU3_ResultOk ? OpenState::open : OpenState::failed);
+    });
+}
+
+Ximu3DeviceManager::Device::OpenState Ximu3DeviceManager::Device::getOpenState(juce::uint32 now) const
+{
+    const auto state = openState->load();
+
+    if (state == OpenState::opening && now - openStartMs > static_cast<juce::uint32>(Connection::openTimeoutMs))
+        return OpenState::failed;
+
+    return state;
+}
+
+void Ximu3DeviceManager::Device::applyStreamSettings(int rateHz, bool useFusion)
+{
+    if (connection && (rateHz != appliedRateHz || useFusion != fusionEnabled.load()))
+    {
+        // Fire and forget - a rejected command is logged, and must not stall discovery
+        Connection::applyStreamRateAsync(*connection, rateHz, useFusion, nullptr);
+        appliedRateHz = rateHz;
+        fusionEnabled.store(useFusion);
+    }
+}
+
+void Ximu3DeviceManager::Device::close()
+{
+    if (connection)
+    {
+        connection->close();
+        connection.reset();
+    }
+}
+
+void Ximu3DeviceManager::Device::pushSample(const IMUData& frame)
+{
+    if (sampleRing.push(frame))
+        notify();
+}
+
+void Ximu3DeviceManager::Device::run()
+{
+    while (!threadShouldExit())
+    {
+        size_t numFrames = 0;
+        while (!threadShouldExit() && (numFrames = sampleRing.pop(block.data(), block.size())) > 0)
+            gestureManager.processBlock(block.data(), numFrames);
+
+        gestureManager.getStats().setSamplesDropped(sampleRing.getOverrunCount());
+
+        // The event stays signalled if a frame landed after the last pop, so this returns at once
+        wait(100);
+    }
+}
+
+//==============================================================================
+Ximu3DeviceManager::Ximu3DeviceManager()
+: juce::Thread("Ximu3DeviceManager Thread")
+{
+}
+
+Ximu3DeviceManager::~Ximu3DeviceManager()
+{
+    stop();
+}
+
+void Ximu3DeviceManager::start()
+{
+    startThread();
+}
+
+void Ximu3DeviceManager::startSynthetic(const SyntheticDeviceSource::Parameters& parameters)
+{
+    stop();
+
+    std::vector<Device*> targets;
+
+    {
+        const juce::ScopedLock sl(devicesLock);
+
+        for (int i = 0; i < parameters.numDevices; ++i)
+        {
+            const auto serial = getSyntheticSerial(i);
+            auto device = std::make_unique<Device>(serial);
+            applySettings(*device);
+            targets.push_back(device.get());
+            devices.emplace(serial, std::move(device));
+        }
+    }
+
+    syntheticSource = std::make_unique<SyntheticDeviceSource>(parameters, [targets](int index, const IMUData& frame)
+    {
+        targets[static_cast<size_t>(index)]->pushSample(frame);
+    });
+
+    syntheticSource->start();
+}
+
+void Ximu3DeviceManager::stop()
+{
+    // Stop producers before tearing down the devices they feed
+    if (syntheticSource)
+    {
+        syntheticSource->stop();
+        reportSyntheticRun();
+        syntheticSource.reset();
+    }
+
+    signalThreadShouldExit();
+    stopThread(2000);
+    removeAllDevices();
+}
+
+juce::String Ximu3DeviceManager::getSyntheticSerial(int index)
+{
+    return "synthetic-" + juce::String(index).paddedLeft('0', 2);
+}
+
+void Ximu3DeviceManager::reportSyntheticRun() const
+{
+    const juce::ScopedLock sl(devicesLock);
+
+    // Same summary as ConnectionManager's single synthetic device, then each device's share,
+    // so a pipeline that falls behind under load shows up as missed taps on particular devices
+    uint64_t tapsDetected = 0;
+    for (const auto& entry : devices)
+        tapsDetected += entry.second->getGestureManager().getTapCount();
+
+    std::cout << "Synthetic: " << devices.size() << " devices, "
+              << syntheticSource->getFramesGenerated() << " frames, "
+              << syntheticSource->getTapsInjected() << " taps injected, "
+              << tapsDetected << " detected, "
+              << getTotalOverruns() << " overruns" << std::endl;
+
+    for (int i = 0; i < static_cast<int>(devices.size()); ++i)
+    {
+        const auto it = devices.find(getSyntheticSerial(i));
+        if (it == devices.end())
+            continue;
+
+        const auto& device = *it->second;
+        std::cout << "  " << device.getSerial().toStdString() << ": "
+                  << syntheticSource->getTapsInjected(i) << " taps injected, "
+                  << device.getGestureManager().getTapCount() << " detected, "
+                  << device.getOverrunCount() << " overruns" << std::endl;
+    }
+}
+
+int Ximu3DeviceManager::getNumDevices() const
+{
+    const juce::ScopedLock sl(devicesLock);
+    return static_cast<int>(devices.size());
+}
+
+juce::StringArray Ximu3DeviceManager::getDeviceSerials() const
+{
+    const juce::ScopedLock sl(devicesLock);
+
+    juce::StringArray serials;
+    for (const auto& entry : devices)
+        serials.add(entry.first);
+
+    return serials;
+}
+
+void Ximu3DeviceManager::setMultiAxisTaps(bool enabled)
+{
+    multiAxisTaps.store(enabled);
+
+    const juce::ScopedLock sl(devicesLock);
+    for (auto& entry : devices)
+        entry.second->getGestureManager().setMultiAxisTaps(enabled);
+}
+
+void Ximu3DeviceManager::setEarlyTaps(bool enabled)
+{
+    earlyTaps.store(enabled);
+
+    const juce::ScopedLock sl(devicesLock);
+    for (auto& entry : devices)
+        entry.second->getGestureManager().setEarlyTaps(enabled);
+}
+
+void Ximu3DeviceManager::setSpectralOnsets(bool enabled, int hopSize)
+{
+    spectralOnsetHop.store(enabled ? juce::jmax(1, hopSize) : 0);
+
+    const juce::ScopedLock sl(devicesLock);
+    for (auto& entry : devices)
+        entry.second->getGestureManager().setSpectralOnsets(enabled, hopSize);
+}
+
+void Ximu3DeviceManager::setHostFusion(bool enabled)
+{
+    hostFusion.store(enabled);
+
+    const juce::ScopedLock sl(devicesLock);
+    for (auto& entry : devices)
+        entry.second->getGestureManager().setHostFusion(enabled);
+}
+
+void Ximu3DeviceManager::setSensorFilters(float highPassHz, float lowPassHz, int order)
+{
+    const juce::ScopedLock sl(devicesLock);
+    sensorFilters.highPassHz = highPassHz;
+    sensorFilters.lowPassHz = lowPassHz;
+    sensorFilters.order = order;
+    
+    for (auto& entry : devices)
+        entry.second->getGestureManager().setSensorFilters(highPassHz, lowPassHz, order);
+}
+
+void Ximu3DeviceManager::setClassifierModel(std::shared_ptr<const GestureClassifier::Model> model)
+{
+    const juce::ScopedLock sl(devicesLock);
+    classifierModel = model;
+    
+    for (auto& entry : devices)
+        entry.second->getGestureManager().setClassifierModel(model);
+}
+
+void Ximu3DeviceManager::setTemplateLibrary(std::shared_ptr<const TemplateMatcher::Library> library)
+{
+    const juce::ScopedLock sl(devicesLock);
+    templateLibrary = library;
+    
+    for (auto& entry : devices)
+        entry.second->getGestureManager().setTemplateLibrary(library);
+}
+
+void Ximu3DeviceManager::setStreamRate(int rateHz)
+{
+    streamRateHz.store(juce::jlimit(Connection::minStreamRateHz, Connection::maxStreamRateHz, rateHz));
+}
+
+uint64_t Ximu3DeviceManager::getTotalOverruns() const
+{
+    const juce::ScopedLock sl(devicesLock);
+
+    uint64_t total = 0;
+    for (const auto& entry : devices)
+        total += entry.second->getOverrunCount();
+
+    return total;
+}
+
+PipelineStats::Snapshot Ximu3DeviceManager::getCombinedStats() const
+{
+    const juce::ScopedLock sl(devicesLock);
+
+    PipelineStats::Snapshot combined;
+    for (const auto& entry : devices)
+    {
+        const auto s = entry.second->getGestureManager().getStats().getSnapshot();
+        combined.linkDataRate += s.linkDataRate;
+        combined.linkMessageRate += s.linkMessageRate;
+        combined.linkErrorRate += s.linkErrorRate;
+        combined.linkErrorTotal += s.linkErrorTotal;
+        combined.samplesProcessed += s.samplesProcessed;
+        combined.samplesDropped += s.samplesDropped;
+        combined.meanDetectorMicros = juce::jmax(combined.meanDetectorMicros, s.meanDetectorMicros);
+        combined.maxDetectorMicros = juce::jmax(combined.maxDetectorMicros, s.maxDetectorMicros);
+    }
+
+    return combined;
+}
+
+void Ximu3DeviceManager::run()
+{
+    std::unique_ptr<ximu3::NetworkAnnouncement> networkAnnouncement;
+
+    try
+    {
+        networkAnnouncement = std::make_unique<ximu3::NetworkAnnouncement>();
+
+        if (networkAnnouncement->getResult() != ximu3::XIMU3_ResultOk)
+        {
+            DBG("ERROR: Unable to open network announcement socket");
+            DBG("Make sure x-IMU3 GUI is closed and port 10000 is available");
+            return;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        DBG("Exception creating network announcement: " << e.what());
+        return;
+    }
+
+    while (!threadShouldExit())
+    {
+        const auto messages = networkAnnouncement->getMessagesAfterShortDelay();
+        const auto now = juce::Time::getMillisecondCounter();
+
+        for (const auto& message : messages)
+        {
+            if (threadShouldExit())
+                break;
+
+            const auto it = devices.find(juce::String(message.serial_number));
+
+            if (it != devices.end())
+                it->second->lastSeenMs = now;
+            else if (pendingDevices.count(juce::String(message.serial_number)) == 0)
+                connectDevice(message);
+        }
+
+        promotePendingDevices(now);
+
+        for (auto& entry : devices)
+            entry.second->applyStreamSettings(streamRateHz.load(), useDeviceFusion.load());
+
+        removeStaleDevices(now);
+        juce::Thread::sleep(100);
+    }
+}
+
+void Ximu3DeviceManager::connectDevice(const ximu3::XIMU3_NetworkAnnouncementMessage& message)
+{
+    const juce::String serial(message.serial_number);
+    auto device = std::make_unique<Device>(serial);
+
+    // Opened in the background, so one slow device doesn't hold up discovery of the rest
+    const auto udpInfo = ximu3::XIMU3_network_announcement_message_to_udp_connection_info(message);
+    device->open(ximu3::UdpConnectionInfo(udpInfo));
+
+    DBG("Connecting: " << message.device_name << " [" << serial << "]"
+        << " (Battery: " << static_cast<int>(message.battery) << "%)");
+
+    pendingDevices.emplace(serial, std::move(device));
+}
+
+void Ximu3DeviceManager::promotePendingDevices(juce::uint32 now)
+{
+    for (auto it = pendingDevices.begin(); it != pendingDevices.end();)
+    {
+        auto& device = *it->second;
+        const auto state = device.getOpenState(now);
+
+        if (state == Device::OpenState::opening)
+        {
+            ++it;
+            continue;
+        }
+
+        if (state == Device::OpenState::open)
+        {
+            DBG("Connected: " << it->first);
+            device.lastSeenMs = now;
+            device.applyStreamSettings(streamRateHz.load(), useDeviceFusion.load());
+
+            // Settings are read under the lock, so a change made meanwhile reaches this device either way
+            const juce::ScopedLock sl(devicesLock);
+            applySettings(device);
+            devices.emplace(it->first, std::move(it->second));
+        }
+        else
+        {
+            DBG("Unable to open " << it->first);
+        }
+
+        it = pendingDevices.erase(it);
+    }
+}
+
+void Ximu3DeviceManager::applySettings(Device& device)
+{
+    auto& manager = device.getGestureManager();
+    manager.setMultiAxisTaps(multiAxisTaps.load());
+    manager.setEarlyTaps(earlyTaps.load());
+    manager.setSpectralOnsets(spectralOnsetHop.load() > 0, spectralOnsetHop.load());
+    manager.setHostFusion(hostFusion.load());
+    manager.setClassifierModel(classifierModel);
+    manager.setTemplateLibrary(templateLibrary);
+    manager.setSensorFilters(sensorFilters.highPassHz, sensorFilters.lowPassHz, sensorFilters.order);
+}
+
+void Ximu3DeviceManager::removeStaleDevices(juce::uint32 now)
+{
+    std::vector<std::unique_ptr<Device>> stale;
+
+    {
+        const juce::ScopedLock sl(devicesLock);
+
+        for (auto it = devices.begin(); it != devices.end();)
+        {
+            if (now - it->second->lastSeenMs > DEVICE_TIMEOUT_MS)
+            {
+                DBG("Device lost: " << it->first);
+                stale.push_back(std::move(it->second));
+                it = devices.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    // Destroyed outside the lock - closing a connection waits for its callbacks
+    stale.clear();
+}
+
+void Ximu3DeviceManager::removeAllDevices()
+{
+    // Only called once discovery has stopped, so nothing else touches the pending devices
+    pendingDevices.clear();
+
+    std::map<juce::String, std::unique_ptr<Device>> removed;
+
+    {
+        const juce::ScopedLock sl(devicesLock);
+        removed.swap(devices);
+    }
+
+    removed.clear();
+}
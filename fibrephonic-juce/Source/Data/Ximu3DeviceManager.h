@@ -9,19 +9,170 @@
 
 #include <JuceHeader.h>
 #include <x-IMU3/Cpp/Ximu3.hpp>
+#include <map>
+#include <memory>
+#include <atomic>
+#include "GestureManager.h"
+#include "SampleRing.h"
+#include "SyntheticDeviceSource.h"
+#include "../Connection.h"
+#include "../Helpers.h"
 
-class Ximu3DeviceManager : private Thread
+/**
+ * @class Ximu3DeviceManager
+ * @brief Multi-device ingest engine for several textile patches at once
+ *
+ * A discovery thread listens for network announcements and keeps one
+ * ximu3::Connection open per device, keyed by serial number. Each device owns
+ * its own sample ring and GestureManager (detector + OSC output under the
+ * "/device/<serial>" address prefix). Each device drains its ring on its own
+ * high-priority thread, woken as frames arrive, so processing spreads across
+ * CPUs as sensors are added rather than funnelling through a single thread.
+ */
+class Ximu3DeviceManager : private juce::Thread
 {
 public:
-    Ximu3DeviceManager() : Thread("Ximu3DeviceManager Thread")
+    Ximu3DeviceManager();
+    ~Ximu3DeviceManager() override;
+
+    /** @brief Start discovery and connect to every announced device */
+    void start();
+
+    /** @brief Run numDevices synthetic devices through the per-device pipelines instead of discovery */
+    void startSynthetic(const SyntheticDeviceSource::Parameters& parameters);
+
+    /** @brief Disconnect all devices and stop discovery */
+    void stop();
+
+    bool isRunning() const { return isThreadRunning() || syntheticSource != nullptr; }
+
+    /** @brief Number of devices currently connected */
+    int getNumDevices() const;
+
+    /** @brief Serial numbers of the connected devices */
+    juce::StringArray getDeviceSerials() const;
+
+    /** @brief Total frames dropped because a device's worker fell behind */
+    uint64_t getTotalOverruns() const;
+
+    /** @brief Link and pipeline metrics summed (rates, counts) or maxed (timings) across devices */
+    PipelineStats::Snapshot getCombinedStats() const;
+
+    /** @brief Request an inertial stream rate for every device, current and future */
+    void setStreamRate(int rateHz);
+
+    /** @brief Detect taps on all accel/gyro axes on every device, current and future */
+    void setMultiAxisTaps(bool enabled);
+    
+    /** @brief Send a tap onset at the threshold crossing ahead of each tap, on every device, current and future */
+    void setEarlyTaps(bool enabled);
+    
+    /** @brief Spectral-flux onset detection on every device, current and future (hop 0 = off) */
+    void setSpectralOnsets(bool enabled, int hopSize = 1);
+    
+    /** @brief Classify gestures on every device, current and future, with one shared model (nullptr = off) */
+    void setClassifierModel(std::shared_ptr<const GestureClassifier::Model> model);
+    
+    /** @brief DTW template matching on every device, current and future, with one shared library (nullptr = off) */
+    void setTemplateLibrary(std::shared_ptr<const TemplateMatcher::Library> library);
+
+    /** @brief Stream each device's AHRS output and detect on gravity-free acceleration */
+    void setUseDeviceFusion(bool shouldUse) { useDeviceFusion.store(shouldUse); }
+    
+    /** @brief Host-side AHRS for devices not streaming their own, on every device, current and future */
+    void setHostFusion(bool enabled);
+    
+    /** @brief Band-limit every device's axes before detection (0 Hz = off), current and future */
+    void setSensorFilters(float highPassHz, float lowPassHz, int order = 2);
+
+    /** @brief Per-device state - connection, sample stream and gesture pipeline */
+    class Device : private juce::Thread
     {
+    public:
+        explicit Device(const juce::String& serialNumber);
+        ~Device() override;
+
+        enum class OpenState { opening, open, failed };
+
+        /** @brief Start opening the connection in the background - poll getOpenState() for the result */
+        void open(const ximu3::ConnectionInfo& connectionInfo);
+
+        /** @brief Whether the open has finished - one still going after Connection::openTimeoutMs counts as failed */
+        OpenState getOpenState(juce::uint32 now) const;
+
+        /** @brief Renegotiate the streams if the rate or fusion setting differs from those last applied */
+        void applyStreamSettings(int rateHz, bool useFusion);
 
-    }
-    ~Ximu3DeviceManager() = default;
+        /** @brief Stop callbacks from the SDK - must be called before destruction */
+        void close();
+
+        /** @brief Queue a frame and wake the processing thread - called from the producer thread only */
+        void pushSample(const IMUData& frame);
+
+        const juce::String& getSerial() const { return serial; }
+        GestureManager& getGestureManager() { return gestureManager; }
+        const GestureManager& getGestureManager() const { return gestureManager; }
+        uint64_t getOverrunCount() const { return sampleRing.getOverrunCount(); }
+
+        juce::uint32 lastSeenMs = 0; ///< Last announcement time, owned by the discovery thread
+
+    private:
+        void run() override;
+
+        const juce::String serial;
+        GestureManager gestureManager;
+
+        std::unique_ptr<ximu3::Connection> connection;
+        std::function<void(ximu3::XIMU3_InertialMessage message)> inertialCallback;
+        std::function<void(ximu3::XIMU3_MagnetometerMessage message)> magnetometerCallback;
+        std::function<void(ximu3::XIMU3_LinearAccelerationMessage message)> linearAccelerationCallback;
+        std::function<void(ximu3::XIMU3_Statistics statistics)> statisticsCallback;
+
+        /** Shared with the open callback, which may fire after the Device has gone */
+        std::shared_ptr<std::atomic<OpenState>> openState = std::make_shared<std::atomic<OpenState>>(OpenState::opening);
+        juce::uint32 openStartMs = 0;
+
+        std::atomic<float> magX{0.0f}, magY{0.0f}, magZ{0.0f};
+        std::atomic<float> linearX{0.0f}, linearY{0.0f}, linearZ{0.0f};
+        std::atomic<float> quatW{1.0f}, quatX{0.0f}, quatY{0.0f}, quatZ{0.0f};
+        std::atomic<bool> fusionReceived{false};
+        std::atomic<bool> fusionEnabled{false};
+        int appliedRateHz = 0; ///< Stream rate last sent, owned by the discovery thread
+
+        SampleRing<IMUData, 4096> sampleRing; ///< ~4 s of headroom at 1 kHz
+        std::array<IMUData, GestureManager::MAX_BLOCK_FRAMES> block; ///< Frames drained per pass by run()
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Device)
+    };
 
 private:
-    void run() override
-    {
+    /** Devices that have not re-announced for this long are disconnected */
+    static constexpr juce::uint32 DEVICE_TIMEOUT_MS = 5000;
+
+    void run() override;
+    void connectDevice(const ximu3::XIMU3_NetworkAnnouncementMessage& message);
+    void promotePendingDevices(juce::uint32 now);
+    void applySettings(Device& device); ///< Caller holds devicesLock
+    void removeStaleDevices(juce::uint32 now);
+    void removeAllDevices();
+    void reportSyntheticRun() const;   ///< Frames, taps injected and detected, and overruns, to stdout
+    static juce::String getSyntheticSerial(int index);
+
+    std::atomic<int> streamRateHz{Connection::defaultStreamRateHz};
+    std::atomic<bool> useDeviceFusion{false};
+    std::atomic<bool> multiAxisTaps{false};
+    std::atomic<bool> earlyTaps{false};
+    std::atomic<int> spectralOnsetHop{0};
+    std::atomic<bool> hostFusion{false};
+    std::shared_ptr<const GestureClassifier::Model> classifierModel; ///< Guarded by devicesLock
+    std::shared_ptr<const TemplateMatcher::Library> templateLibrary; ///< Guarded by devicesLock
+    SensorFilterBank::Settings sensorFilters;                        ///< Guarded by devicesLock
+
+    std::unique_ptr<SyntheticDeviceSource> syntheticSource;
+
+    std::map<juce::String, std::unique_ptr<Device>> devices; ///< Keyed by serial number
+    std::map<juce::String, std::unique_ptr<Device>> pendingDevices; ///< Still opening, owned by the discovery thread
+    juce::CriticalSection devicesLock; ///< Guards the map for readers off the discovery thread
 
-    }
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Ximu3DeviceManager)
 };
@@ -10,23 +10,41 @@
 
 #pragma once
 
+#include <cstdint>
+#include <string>
+
 /** @brief IMU data container */
 struct IMUData
 {
     float accelX, accelY, accelZ;
     float gyroX, gyroY, gyroZ;
     float magX, magY, magZ;
+    uint64_t timestamp;   ///< Device timestamp in microseconds (0 if unknown)
+
+    // On-device AHRS output, only valid when hasFusion is set
+    float linearAccelX, linearAccelY, linearAccelZ;   ///< Gravity-free acceleration (g), sensor frame
+    float quatW, quatX, quatY, quatZ;                 ///< Orientation
+    bool hasFusion;
 
     IMUData() : accelX(0), accelY(0), accelZ(0),
                 gyroX(0), gyroY(0), gyroZ(0),
-                magX(0), magY(0), magZ(0) {}
+                magX(0), magY(0), magZ(0),
+                timestamp(0),
+                linearAccelX(0), linearAccelY(0), linearAccelZ(0),
+                quatW(1), quatX(0), quatY(0), quatZ(0),
+                hasFusion(false) {}
 
     IMUData(float ax, float ay, float az,
             float gx, float gy, float gz,
-            float mx, float my, float mz)
+            float mx, float my, float mz,
+            uint64_t t = 0)
         : accelX(ax), accelY(ay), accelZ(az),
           gyroX(gx), gyroY(gy), gyroZ(gz),
-          magX(mx), magY(my), magZ(mz) {}
+          magX(mx), magY(my), magZ(mz),
+          timestamp(t),
+          linearAccelX(0), linearAccelY(0), linearAccelZ(0),
+          quatW(1), quatX(0), quatY(0), quatZ(0),
+          hasFusion(false) {}
 };
 
 struct Gestures
@@ -39,7 +57,9 @@ struct Gestures
         STROKE_UP,
         STROKE_DOWN,
         STROKE_LEFT,
-        STROKE_RIGHT
+        STROKE_RIGHT,
+        ONSET,
+        TAP_ONSET
     };
 
     static std::string getGestureName(GestureType g)
@@ -52,6 +72,8 @@ struct Gestures
             case STROKE_DOWN: return "Stroke Down";
             case STROKE_LEFT: return "Stroke Left";
             case STROKE_RIGHT: return "Stroke Right";
+            case ONSET: return "Onset";
+            case TAP_ONSET: return "Tap Onset";
             default: return "Unknown";
         }
     }
@@ -20,7 +20,76 @@ public:
 
     void initialise(const juce::String& commandLine) override
     {
+        juce::StringArray args;
+        args.addTokens(commandLine, true);
+        
+        // --run-tests
+        // Runs the unit tests (the lock-free queue stress tests) without opening a window,
+        // and exits with 1 if any failed
+        if (args.contains("--run-tests"))
+        {
+            juce::UnitTestRunner runner;
+            runner.runAllTests();
+            
+            int failures = 0;
+            for (int i = 0; i < runner.getNumResults(); ++i)
+                failures += runner.getResult(i)->failures;
+            
+            setApplicationReturnValue(failures > 0 ? 1 : 0);
+            quit();
+            return;
+        }
+        
         mainWindow.reset(new MainWindow(getApplicationName()));
+        
+        // --model <features.csv>
+        // Classify gestures with a model recorded by GestureRecorder
+        const int modelIndex = args.indexOf("--model");
+        if (modelIndex >= 0 && modelIndex + 1 < args.size())
+        {
+            if (auto* mainComponent = dynamic_cast<MainComponent*>(mainWindow->getContentComponent()))
+                mainComponent->loadClassifier(juce::File(args[modelIndex + 1].unquoted()));
+        }
+        
+        // --templates <templates.csv>
+        // Match gestures against DTW templates recorded by GestureRecorder
+        const int templatesIndex = args.indexOf("--templates");
+        if (templatesIndex >= 0 && templatesIndex + 1 < args.size())
+        {
+            if (auto* mainComponent = dynamic_cast<MainComponent*>(mainWindow->getContentComponent()))
+                mainComponent->loadTemplates(juce::File(args[templatesIndex + 1].unquoted()));
+        }
+        
+        // --replay <session.ximu3> [--fast] [--quit]
+        // Feeds a recording through the live pipeline; --fast runs it as quickly as
+        // possible to benchmark throughput, --quit exits once it has been processed
+        const int replayIndex = args.indexOf("--replay");
+        if (replayIndex >= 0 && replayIndex + 1 < args.size())
+        {
+            if (auto* mainComponent = dynamic_cast<MainComponent*>(mainWindow->getContentComponent()))
+            {
+                mainComponent->startReplay(juce::File(args[replayIndex + 1].unquoted()),
+                                           !args.contains("--fast"),
+                                           args.contains("--quit"));
+            }
+        }
+        
+        // --synthetic <devices> [--rate <hz>] [--fast]
+        // Stress test with generated streams, e.g. --synthetic 32 --rate 1000
+        const int syntheticIndex = args.indexOf("--synthetic");
+        if (syntheticIndex >= 0 && syntheticIndex + 1 < args.size())
+        {
+            SyntheticDeviceSource::Parameters parameters;
+            parameters.numDevices = juce::jmax(1, args[syntheticIndex + 1].getIntValue());
+            parameters.realTime = !args.contains("--fast");
+            
+            const int rateIndex = args.indexOf("--rate");
+            if (rateIndex >= 0 && rateIndex + 1 < args.size())
+                parameters.rateHz = juce::jmax(1.0, args[rateIndex + 1].getDoubleValue());
+            
+            if (auto* mainComponent = dynamic_cast<MainComponent*>(mainWindow->getContentComponent()))
+                mainComponent->startSynthetic(parameters);
+        }
     }
 
     void shutdown() override
@@ -14,19 +14,18 @@ MainComponent::MainComponent()
     // Set up the circular reference
     gestureManager->setConnectionManager(connectionManager);
     
+    deviceManager = std::make_unique<Ximu3DeviceManager>();
+    
     // Create calibration component
-    if (gestureManager->getDetector())
-    {
-        calibrationComponent = std::make_unique<CalibrationComponent>(*gestureManager->getDetector());
-        addAndMakeVisible(calibrationComponent.get());
-    }
+    calibrationComponent = std::make_unique<CalibrationComponent>(*gestureManager);
+    addAndMakeVisible(calibrationComponent.get());
     
     setupUI();
     
     // Start UI update timer
     startTimerHz(10); // Update UI 10 times per second
     
-    setSize(600, 450); // Increased width for calibration panel
+    setSize(900, 570); // Increased width for calibration panel
 }
 
 MainComponent::~MainComponent()
@@ -39,9 +38,12 @@ MainComponent::~MainComponent()
         connectionManager->stopConnection();
     }
     
-    // Clean up references
+    deviceManager.reset();
+    
+    // Stop the processing thread before dropping its connection reference
     if (gestureManager)
     {
+        gestureManager->stopPolling();
         gestureManager->setConnectionManager(nullptr);
     }
     
@@ -65,6 +67,128 @@ void MainComponent::setupUI()
     toggleButton.setColour(juce::TextButton::buttonColourId, juce::Colours::forestgreen);
     toggleButton.onClick = [this] { toggleConnection(); };
     
+    addAndMakeVisible(multiDeviceToggle);
+    multiDeviceToggle.setButtonText("Connect all devices");
+    multiDeviceToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    
+    // Stream rate selection - can be changed while connected
+    addAndMakeVisible(streamRateBox);
+    for (int rate : { 100, 200, 400, 800, 1000 })
+        streamRateBox.addItem(juce::String(rate) + " Hz", rate);
+    streamRateBox.setSelectedId(Connection::defaultStreamRateHz, juce::dontSendNotification);
+    streamRateBox.onChange = [this] { applyStreamRate(); };
+    
+    // On-device orientation and gravity removal - can be changed while connected
+    addAndMakeVisible(deviceFusionToggle);
+    deviceFusionToggle.setButtonText("Use device AHRS (gravity-free acceleration)");
+    deviceFusionToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    deviceFusionToggle.onClick = [this] { applyDeviceFusion(); };
+    
+    // Orientation estimated on the host for devices that don't stream their own
+    addAndMakeVisible(hostFusionToggle);
+    hostFusionToggle.setButtonText("Host AHRS when the device sends none");
+    hostFusionToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    hostFusionToggle.onClick = [this]
+    {
+        const bool enabled = hostFusionToggle.getToggleState();
+        
+        if (gestureManager)
+            gestureManager->setHostFusion(enabled);
+        
+        if (deviceManager)
+            deviceManager->setHostFusion(enabled);
+    };
+    
+    // Band-limit the axes before detection: drops gravity, bias and drift below, sensor noise above
+    addAndMakeVisible(sensorFilterToggle);
+    sensorFilterToggle.setButtonText("Filter axes (0.25-40 Hz)");
+    sensorFilterToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    sensorFilterToggle.onClick = [this]
+    {
+        const bool enabled = sensorFilterToggle.getToggleState();
+        const float highPassHz = enabled ? 0.25f : 0.0f;
+        const float lowPassHz = enabled ? 40.0f : 0.0f;
+        
+        if (gestureManager)
+            gestureManager->setSensorFilters(highPassHz, lowPassHz);
+        
+        if (deviceManager)
+            deviceManager->setSensorFilters(highPassHz, lowPassHz);
+    };
+    
+    addAndMakeVisible(multiAxisTapToggle);
+    multiAxisTapToggle.setButtonText("Taps on all axes");
+    multiAxisTapToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    multiAxisTapToggle.onClick = [this]
+    {
+        const bool enabled = multiAxisTapToggle.getToggleState();
+        
+        if (gestureManager)
+            gestureManager->setMultiAxisTaps(enabled);
+        
+        if (deviceManager)
+            deviceManager->setMultiAxisTaps(enabled);
+    };
+    
+    // Percussion: a tap onset at the threshold crossing, its velocity once the peak has passed
+    addAndMakeVisible(earlyTapToggle);
+    earlyTapToggle.setButtonText("Early tap onsets");
+    earlyTapToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    earlyTapToggle.onClick = [this]
+    {
+        const bool enabled = earlyTapToggle.getToggleState();
+        
+        if (gestureManager)
+            gestureManager->setEarlyTaps(enabled);
+        
+        if (deviceManager)
+            deviceManager->setEarlyTaps(enabled);
+    };
+    
+    // Soft-touch onsets from the spectral flux, transformed every frame
+    addAndMakeVisible(spectralOnsetToggle);
+    spectralOnsetToggle.setButtonText("Spectral onsets (soft touches)");
+    spectralOnsetToggle.setColour(juce::ToggleButton::textColourId, juce::Colours::white);
+    spectralOnsetToggle.onClick = [this]
+    {
+        const bool enabled = spectralOnsetToggle.getToggleState();
+        
+        if (gestureManager)
+            gestureManager->setSpectralOnsets(enabled);
+        
+        if (deviceManager)
+            deviceManager->setSpectralOnsets(enabled);
+    };
+    
+    // Gesture classifier trained from recorded feature windows
+    addAndMakeVisible(classifierButton);
+    classifierButton.setButtonText("Load classifier...");
+    classifierButton.onClick = [this]
+    {
+        fileChooser = std::make_unique<juce::FileChooser>("Select a recorded gesture CSV",
+                                                                juce::File(), "*.csv");
+        fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                       [this](const juce::FileChooser& chooser)
+        {
+            if (chooser.getResult() != juce::File())
+                loadClassifier(chooser.getResult());
+        });
+    };
+    
+    addAndMakeVisible(templatesButton);
+    templatesButton.setButtonText("Load templates...");
+    templatesButton.onClick = [this]
+    {
+        fileChooser = std::make_unique<juce::FileChooser>("Select a recorded template CSV",
+                                                                juce::File(), "*.csv");
+        fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                       [this](const juce::FileChooser& chooser)
+        {
+            if (chooser.getResult() != juce::File())
+                loadTemplates(chooser.getResult());
+        });
+    };
+    
     // Status labels
     addAndMakeVisible(connectionLabel);
     connectionLabel.setText("Connection: Disconnected", juce::dontSendNotification);
@@ -81,6 +205,11 @@ void MainComponent::setupUI()
     sensorDataLabel.setFont(juce::FontOptions(12.0f));
     sensorDataLabel.setJustificationType(juce::Justification::topLeft);
     sensorDataLabel.setColour(juce::Label::textColourId, juce::Colours::darkslategrey);
+    
+    addAndMakeVisible(statsLabel);
+    statsLabel.setFont(juce::FontOptions(12.0f));
+    statsLabel.setJustificationType(juce::Justification::topLeft);
+    statsLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
 }
 
 void MainComponent::paint(juce::Graphics& g)
@@ -129,6 +258,24 @@ void MainComponent::resized()
     // Control buttons
     auto buttonArea = mainBounds.removeFromTop(50);
     toggleButton.setBounds(buttonArea.removeFromLeft(180));
+    buttonArea.removeFromLeft(10);
+    multiDeviceToggle.setBounds(buttonArea.removeFromLeft(180));
+    buttonArea.removeFromLeft(10);
+    streamRateBox.setBounds(buttonArea.removeFromLeft(100).withSizeKeepingCentre(100, 30));
+    mainBounds.removeFromTop(5);
+    auto optionArea = mainBounds.removeFromTop(30);
+    deviceFusionToggle.setBounds(optionArea.removeFromLeft(320));
+    multiAxisTapToggle.setBounds(optionArea.removeFromLeft(180));
+    auto fusionArea = mainBounds.removeFromTop(30);
+    hostFusionToggle.setBounds(fusionArea.removeFromLeft(320));
+    sensorFilterToggle.setBounds(fusionArea.removeFromLeft(200));
+    earlyTapToggle.setBounds(mainBounds.removeFromTop(30).removeFromLeft(320));
+    auto analysisArea = mainBounds.removeFromTop(30);
+    spectralOnsetToggle.setBounds(analysisArea.removeFromLeft(240));
+    analysisArea.removeFromLeft(10);
+    classifierButton.setBounds(analysisArea.removeFromLeft(120).withSizeKeepingCentre(120, 26));
+    analysisArea.removeFromLeft(10);
+    templatesButton.setBounds(analysisArea.removeFromLeft(120).withSizeKeepingCentre(120, 26));
     mainBounds.removeFromTop(20);
     
     // Status section
@@ -139,6 +286,7 @@ void MainComponent::resized()
     mainBounds.removeFromTop(5);
     
     sensorDataLabel.setBounds(mainBounds.removeFromTop(150));
+    statsLabel.setBounds(mainBounds.removeFromTop(40));
     
     // Calibration component on the right
     if (calibrationComponent)
@@ -158,11 +306,30 @@ void MainComponent::updateUI()
         return;
 
     // Connection status
+    if (deviceManager && deviceManager->isRunning())
+    {
+        const int numDevices = deviceManager->getNumDevices();
+        connectionLabel.setText("Connection: " + juce::String(numDevices) + " device(s)"
+                                + "   Overruns: " + juce::String((juce::int64) deviceManager->getTotalOverruns()),
+                                juce::dontSendNotification);
+        connectionLabel.setColour(juce::Label::textColourId,
+                                  numDevices > 0 ? juce::Colours::green : juce::Colours::red);
+        sensorDataLabel.setText("Devices:\n" + deviceManager->getDeviceSerials().joinIntoString("\n"),
+                                juce::dontSendNotification);
+        updateStats(deviceManager->getCombinedStats());
+        
+        toggleButton.setButtonText("Stop Connection");
+        toggleButton.setColour(juce::TextButton::buttonColourId, juce::Colours::indianred);
+        return;
+    }
+    
     bool connected = connectionManager->getIsConnected();
     connectionLabel.setText("Connection: " + juce::String(connected ? "Connected" : "Disconnected"),
                            juce::dontSendNotification);
     connectionLabel.setColour(juce::Label::textColourId,
                              connected ? juce::Colours::green : juce::Colours::red);
+    
+    updateStats(gestureManager->getStats().getSnapshot());
 
     // Toggle button
     toggleButton.setButtonText(isRunning ? "Stop Connection" : "Start Connection");
@@ -176,6 +343,12 @@ void MainComponent::updateUI()
         gestureLabel.setText("Last Gesture: Tap (velocity: " + juce::String(lastTapVelocity, 1) + ")",
                             juce::dontSendNotification);
     }
+    else if (gestureManager->getLastStrokeDirection() != Gestures::NONE)
+    {
+        gestureLabel.setText("Last Gesture: " + juce::String(Gestures::getGestureName(gestureManager->getLastStrokeDirection()))
+                             + " (" + juce::String(gestureManager->getLastStrokeSpeed(), 2) + " m/s)",
+                             juce::dontSendNotification);
+    }
     else
     {
         gestureLabel.setText("Last Gesture: None", juce::dontSendNotification);
@@ -215,7 +388,25 @@ void MainComponent::updateUI()
                    << "   Y: " << juce::String(connectionManager->getMagnetometerY(), 2)
                    << "   Z: " << juce::String(connectionManager->getMagnetometerZ(), 2) << "\n\n";
 
-        sensorInfo << "Calibration: " << (gestureManager->isCalibrated() ? "YES" : "NO");
+        sensorInfo << "Calibration: " << (gestureManager->isCalibrated() ? "YES" : "NO") << "\n";
+        
+        const int classIndex = gestureManager->getClassIndex();
+        if (classifierModel && classIndex >= 0)
+        {
+            sensorInfo << "Class: " << classifierModel->labels[classIndex]
+                       << " (" << juce::roundToInt(gestureManager->getClassConfidence() * 100.0f) << "%)\n";
+        }
+        
+        const int matchIndex = gestureManager->getMatchLabelIndex();
+        if (templateLibrary && matchIndex >= 0)
+        {
+            sensorInfo << "Template: " << templateLibrary->labels[matchIndex]
+                       << " (distance " << juce::String(gestureManager->getMatchDistance(), 2) << ")\n";
+        }
+
+        sensorInfo << "Rate: " << juce::String(gestureManager->getMeasuredSampleRate(), 1) << " Hz"
+                   << "   Samples: " << juce::String((juce::int64) connectionManager->getSamplesReceived())
+                   << "   Overruns: " << juce::String((juce::int64) connectionManager->getSampleOverruns());
 
         sensorDataLabel.setText(sensorInfo, juce::dontSendNotification);
         sensorDataLabel.setColour(juce::Label::textColourId, juce::Colours::darkslategrey);
@@ -228,24 +419,157 @@ void MainComponent::updateUI()
     }
 }
 
+void MainComponent::updateStats(const PipelineStats::Snapshot& stats)
+{
+    juce::String statsInfo;
+    statsInfo << "Link: " << juce::String(stats.linkDataRate / 1024.0, 1) << " KB/s   "
+              << juce::String(stats.linkMessageRate) << " msg/s   "
+              << juce::String(stats.linkErrorRate) << " err/s\n";
+    statsInfo << "Pipeline: " << juce::String((juce::int64) stats.samplesProcessed) << " processed   "
+              << juce::String((juce::int64) stats.samplesDropped) << " dropped   "
+              << "detector " << juce::String(stats.meanDetectorMicros, 1) << " us (peak "
+              << juce::String(stats.maxDetectorMicros, 1) << " us)";
+    
+    statsLabel.setText(statsInfo, juce::dontSendNotification);
+    statsLabel.setColour(juce::Label::textColourId,
+                         stats.samplesDropped > 0 || stats.linkErrorRate > 0 ? juce::Colours::orange
+                                                                            : juce::Colours::grey);
+}
+
 void MainComponent::toggleConnection()
 {
     if (!isRunning)
     {
         DBG("Starting connection...");
-        if (connectionManager)
+        if (multiDeviceToggle.getToggleState() && deviceManager)
+        {
+            deviceManager->start();
+            isRunning = true;
+        }
+        else if (connectionManager)
         {
             connectionManager->startConnection();
             isRunning = true;
         }
+        multiDeviceToggle.setEnabled(!isRunning);
     }
     else
     {
         DBG("Stopping connection...");
-        if (connectionManager)
+        if (deviceManager && deviceManager->isRunning())
+        {
+            deviceManager->stop();
+            isRunning = false;
+        }
+        else if (connectionManager)
         {
             connectionManager->stopConnection();
             isRunning = false;
         }
+        multiDeviceToggle.setEnabled(true);
     }
 }
+
+void MainComponent::applyStreamRate()
+{
+    const int rate = streamRateBox.getSelectedId();
+    
+    if (connectionManager)
+        connectionManager->setStreamRate(rate);
+    
+    if (deviceManager)
+        deviceManager->setStreamRate(rate);
+}
+
+void MainComponent::applyDeviceFusion()
+{
+    const bool useFusion = deviceFusionToggle.getToggleState();
+    
+    if (connectionManager)
+        connectionManager->setUseDeviceFusion(useFusion);
+    
+    if (deviceManager)
+        deviceManager->setUseDeviceFusion(useFusion);
+}
+
+void MainComponent::startReplay(const juce::File& sessionFile, bool realTime, bool quitWhenFinished)
+{
+    if (!connectionManager || isRunning)
+        return;
+    
+    DBG("Replaying " << sessionFile.getFullPathName());
+    
+    if (quitWhenFinished)
+    {
+        connectionManager->onReplayFinished = []
+        {
+            juce::MessageManager::callAsync([] { juce::JUCEApplication::quit(); });
+        };
+    }
+    
+    connectionManager->startReplay(sessionFile, realTime);
+    isRunning = true;
+    multiDeviceToggle.setEnabled(false);
+}
+
+void MainComponent::loadClassifier(const juce::File& modelFile)
+{
+    classifierModel = GestureClassifier::loadModel(modelFile);
+    
+    if (!classifierModel)
+    {
+        juce::AlertWindow::showAsync(MessageBoxOptions()
+                                     .withIconType(MessageBoxIconType::WarningIcon)
+                                     .withTitle("Classifier")
+                                     .withMessage("No labelled feature rows found in " + modelFile.getFileName())
+                                     .withButton("Close"),
+                                     nullptr);
+        return;
+    }
+    
+    if (gestureManager)
+        gestureManager->setClassifierModel(classifierModel);
+    
+    if (deviceManager)
+        deviceManager->setClassifierModel(classifierModel);
+    
+    classifierButton.setButtonText(modelFile.getFileNameWithoutExtension());
+}
+
+void MainComponent::loadTemplates(const juce::File& templateFile)
+{
+    templateLibrary = TemplateMatcher::loadLibrary(templateFile);
+    
+    if (!templateLibrary)
+    {
+        juce::AlertWindow::showAsync(MessageBoxOptions()
+                                     .withIconType(MessageBoxIconType::WarningIcon)
+                                     .withTitle("Templates")
+                                     .withMessage("No gesture templates found in " + templateFile.getFileName())
+                                     .withButton("Close"),
+                                     nullptr);
+        return;
+    }
+    
+    if (gestureManager)
+        gestureManager->setTemplateLibrary(templateLibrary);
+    
+    if (deviceManager)
+        deviceManager->setTemplateLibrary(templateLibrary);
+    
+    templatesButton.setButtonText(templateFile.getFileNameWithoutExtension());
+}
+
+void MainComponent::startSynthetic(const SyntheticDeviceSource::Parameters& parameters)
+{
+    if (isRunning)
+        return;
+    
+    if (parameters.numDevices > 1 && deviceManager)
+        deviceManager->startSynthetic(parameters);
+    else if (connectionManager)
+        connectionManager->startSynthetic(parameters);
+    
+    isRunning = true;
+    multiDeviceToggle.setEnabled(false);
+}
@@ -3,6 +3,7 @@
 #include <JuceHeader.h>
 #include "Data/GestureManager.h"
 #include "Data/ConnectionManager.h"
+#include "Data/Ximu3DeviceManager.h"
 #include <memory>
 
 // Forward declaration
@@ -19,23 +20,54 @@ public:
 
     void paint(juce::Graphics&) override;
     void resized() override;
+    
+    /** @brief Replay a recorded .ximu3 session instead of connecting to a device */
+    void startReplay(const juce::File& sessionFile, bool realTime, bool quitWhenFinished);
+    
+    /** @brief Classify gestures with a model recorded by GestureRecorder, on every pipeline */
+    void loadClassifier(const juce::File& modelFile);
+    
+    /** @brief Match gestures against DTW templates recorded by GestureRecorder, on every pipeline */
+    void loadTemplates(const juce::File& templateFile);
+    
+    /** @brief Drive the pipeline from synthetic devices (one uses the main pipeline, more use the multi-device engine) */
+    void startSynthetic(const SyntheticDeviceSource::Parameters& parameters);
 
 private:
     // Core gesture detection system
     std::shared_ptr<GestureManager> gestureManager;
     std::shared_ptr<ConnectionManager> connectionManager;
     
+    // Multi-device engine (one pipeline per discovered sensor)
+    std::unique_ptr<Ximu3DeviceManager> deviceManager;
+    
     // Calibration UI
     std::unique_ptr<CalibrationComponent> calibrationComponent;
     
     // UI Components - Main Controls
     juce::Label titleLabel;
     juce::TextButton toggleButton;
+    juce::ToggleButton multiDeviceToggle;
+    juce::ComboBox streamRateBox;
+    juce::ToggleButton deviceFusionToggle;
+    juce::ToggleButton hostFusionToggle;
+    juce::ToggleButton sensorFilterToggle;
+    juce::ToggleButton multiAxisTapToggle;
+    juce::ToggleButton earlyTapToggle;
+    juce::ToggleButton spectralOnsetToggle;
+    juce::TextButton classifierButton;
+    juce::TextButton templatesButton;
+    std::unique_ptr<juce::FileChooser> fileChooser;
+    
+    // Loaded classifier model and template library, kept for their labels
+    std::shared_ptr<const GestureClassifier::Model> classifierModel;
+    std::shared_ptr<const TemplateMatcher::Library> templateLibrary;
     
     // Status Display
     juce::Label connectionLabel;
     juce::Label gestureLabel;
     juce::Label sensorDataLabel;
+    juce::Label statsLabel;
     
     // Application state
     bool isRunning = false;
@@ -44,7 +76,10 @@ private:
     // Methods
     void timerCallback() override;
     void updateUI();
+    void updateStats(const PipelineStats::Snapshot& stats);
     void toggleConnection();
+    void applyStreamRate();
+    void applyDeviceFusion();
     void setupUI();
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)